@@ -0,0 +1,118 @@
+#include "Gaussian_sphere.h"
+#include "Color_256.h"
+
+#include <cmath>
+#include <algorithm>
+
+const double pi = 3.14159265358979323846;
+
+void Gaussian_sphere::reset(const std::size_t nb_rings, const std::size_t nb_sectors)
+{
+  m_nb_rings = std::max(nb_rings, std::size_t(1));
+  m_nb_sectors = std::max(nb_sectors, std::size_t(1));
+  m_counts.assign(m_nb_rings * m_nb_sectors, 0);
+  m_candidates.assign(m_counts.size(), -1);
+  m_votes.assign(m_counts.size(), 0);
+  m_verified.assign(m_counts.size(), 0);
+  m_hits.assign(m_counts.size(), 0);
+  m_max_count = 0;
+}
+
+void Gaussian_sphere::add(const double x, const double y, const double z, const int label)
+{
+  const double len = std::sqrt(x * x + y * y + z * z);
+  if (len == 0.0 || m_counts.empty())
+    return;
+
+  const std::size_t b = bin(x / len, y / len, z / len);
+  m_max_count = std::max(m_max_count, ++m_counts[b]);
+  if (m_votes[b] == 0) {
+    m_candidates[b] = label;
+    m_votes[b] = 1;
+  }
+  else if (m_candidates[b] == label)
+    ++m_votes[b];
+  else
+    --m_votes[b];
+}
+
+void Gaussian_sphere::verify(const double x, const double y, const double z, const int label)
+{
+  const double len = std::sqrt(x * x + y * y + z * z);
+  if (len == 0.0 || m_counts.empty())
+    return;
+
+  const std::size_t b = bin(x / len, y / len, z / len);
+  ++m_verified[b];
+  if (m_votes[b] > 0 && m_candidates[b] == label)
+    ++m_hits[b];
+}
+
+int Gaussian_sphere::label(const std::size_t bin) const
+{
+  // the vote keeps a label that may be the majority, the count confirms it
+  return 2 * m_hits[bin] > m_verified[bin] ? m_candidates[bin] : -1;
+}
+
+std::size_t Gaussian_sphere::bin(const double x, const double y, const double z) const
+{
+  const std::size_t ring = std::min(m_nb_rings - 1,
+    std::size_t(std::max(0.0, (z + 1.0) / 2.0 * double(m_nb_rings))));
+  double phi = std::atan2(y, x);
+  if (phi < 0.0)
+    phi += 2.0 * pi;
+  const std::size_t sector = std::min(m_nb_sectors - 1,
+    std::size_t(phi / (2.0 * pi) * double(m_nb_sectors)));
+  return ring * m_nb_sectors + sector;
+}
+
+void Gaussian_sphere::to_buffer(
+  Render_buffer &buffer,
+  const double cx, const double cy, const double cz,
+  const double radius,
+  const std::vector<std::size_t> &label_colors) const
+{
+  buffer.clear(cx, cy, cz);
+  buffer.reserve(4 * m_counts.size(), 6 * m_counts.size());
+  const double log_max = std::log(1.0 + double(m_max_count));
+  for (std::size_t ring = 0; ring < m_nb_rings; ++ring) {
+    const double z[2] = {
+      -1.0 + 2.0 * double(ring) / double(m_nb_rings),
+      -1.0 + 2.0 * double(ring + 1) / double(m_nb_rings)};
+    for (std::size_t sector = 0; sector < m_nb_sectors; ++sector) {
+      const double phi[2] = {
+        2.0 * pi * double(sector) / double(m_nb_sectors),
+        2.0 * pi * double(sector + 1) / double(m_nb_sectors)};
+
+      const std::size_t b = ring * m_nb_sectors + sector;
+      unsigned char rgb[3] = {230, 230, 230};
+      if (m_counts[b] > 0) {
+        const double density = log_max > 0.0 ?
+          std::log(1.0 + double(m_counts[b])) / log_max : 1.0;
+        const double shade = 0.25 + 0.75 * density;
+        const int l = label(b);
+        if (l >= 0 && std::size_t(l) < label_colors.size()) {
+          const std::size_t c = label_colors[l];
+          rgb[0] = (unsigned char)(shade * Color_256::r(c));
+          rgb[1] = (unsigned char)(shade * Color_256::g(c));
+          rgb[2] = (unsigned char)(shade * Color_256::b(c));
+        }
+        else
+          rgb[0] = rgb[1] = rgb[2] = (unsigned char)(200.0 * (1.0 - shade));
+      }
+
+      // the cell corners, normals along the radius
+      const std::size_t first = buffer.size();
+      const int corners[4][2] = {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+      for (const auto &c : corners) {
+        const double s = std::sqrt(std::max(0.0, 1.0 - z[c[0]] * z[c[0]]));
+        const double n[3] = {s * std::cos(phi[c[1]]), s * std::sin(phi[c[1]]), z[c[0]]};
+        buffer.add_vertex(
+          cx + radius * n[0], cy + radius * n[1], cz + radius * n[2],
+          n[0], n[1], n[2],
+          rgb[0], rgb[1], rgb[2], 255);
+      }
+      buffer.add_triangle_fan(first, 4);
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef GAUSSIAN_SPHERE_H
+#define GAUSSIAN_SPHERE_H
+
+#include "Render_buffer.h"
+
+#include <vector>
+#include <cstddef>
+
+/*!
+ * \brief Density histogram of normals over the unit sphere.
+ * Bins are equal area: rings uniform in z, sectors uniform in longitude.
+ * Each bin keeps its number of normals and a candidate label by Boyer-Moore
+ * voting, so that adding a normal is constant time and memory does not
+ * depend on the number of labels. The vote only finds the majority if there
+ * is one: a second pass of verify() over the same normals counts the
+ * candidate, which is kept only if it has more than half the bin.
+ * The histogram is drawn as a tessellated sphere, one flat cell per bin.
+ */
+class Gaussian_sphere {
+public:
+  Gaussian_sphere() : m_nb_rings(0), m_nb_sectors(0), m_max_count(0) {}
+
+  /*!
+   * \brief Empty the histogram with nb_rings * nb_sectors bins.
+   */
+  void reset(const std::size_t nb_rings = 32, const std::size_t nb_sectors = 64);
+
+  /*!
+   * \brief Add a normal with its label, negative if it has none.
+   */
+  template <typename Vector>
+  void add(const Vector &n, const int label) {
+    add(n.x(), n.y(), n.z(), label);
+  }
+
+  void add(const double x, const double y, const double z, const int label);
+
+  /*!
+   * \brief Count the normal for its bin candidate, once all normals are added.
+   */
+  template <typename Vector>
+  void verify(const Vector &n, const int label) {
+    verify(n.x(), n.y(), n.z(), label);
+  }
+
+  void verify(const double x, const double y, const double z, const int label);
+
+  std::size_t size() const { return m_counts.size(); }
+
+  std::size_t count(const std::size_t bin) const { return m_counts[bin]; }
+
+  // label of more than half the verified normals of the bin, else -1
+  int label(const std::size_t bin) const;
+
+  /*!
+   * \brief Tessellate the sphere at the center into the buffer as lit
+   * GL_TRIANGLES. A bin takes the Color_256 color label_colors[label] of its
+   * label, or gray without label, darker for fewer normals on a log scale.
+   * Empty bins are light gray.
+   */
+  void to_buffer(Render_buffer &buffer,
+    const double cx, const double cy, const double cz,
+    const double radius,
+    const std::vector<std::size_t> &label_colors) const;
+
+private:
+  std::size_t bin(const double x, const double y, const double z) const;
+
+private:
+  std::size_t m_nb_rings;
+  std::size_t m_nb_sectors;
+
+  std::vector<std::size_t> m_counts;
+  // Boyer-Moore candidate and vote of each bin
+  std::vector<int> m_candidates;
+  std::vector<std::size_t> m_votes;
+  // verified normals of each bin, and how many have its candidate
+  std::vector<std::size_t> m_verified;
+  std::vector<std::size_t> m_hits;
+  std::size_t m_max_count;
+};
+
+#endif // GAUSSIAN_SPHERE_H
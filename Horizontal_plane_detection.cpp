@@ -310,44 +310,64 @@ void Horizontal_plane_detection::detect(
   std::srand(static_cast<unsigned int>(std::time(nullptr)));
   for (std::size_t &c : m_shape_colors)
     c = static_cast<std::size_t>(std::rand() % 255);
+
+  build_buffers();
 }
 
-void Horizontal_plane_detection::draw()
+void Horizontal_plane_detection::build_buffers()
 {
-  if (m_points.empty())
-    return;
-
-  // draw point cloud with respect color
-  ::glDisable(GL_LIGHTING);
-  ::glPointSize(5.0);
-  ::glBegin(GL_POINTS);
+  m_point_buffer.clear(
+    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+  m_point_buffer.reserve(m_points.size());
   for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
+    const Kernel2::Point_3 &p = m_points[pidx].first;
     if (m_point_shapes[pidx] >= 0) {
       const std::size_t cidx = m_shape_colors[m_point_shapes[pidx]];
-      ::glColor3ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
+      m_point_buffer.add_vertex(p, Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
     }
     else
-      ::glColor3ub(0, 0, 0);
-
-    const Kernel2::Point_3 &p = m_points[pidx].first;
-    ::glVertex3d(p.x(), p.y(), p.z());
+      m_point_buffer.add_vertex(p, 0, 0, 0);
   }
-  ::glEnd();
-
-  // draw convex hull of shape points
-  ::glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  ::glEnable(GL_BLEND);
-  ::glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  m_point_octree.build(m_point_buffer);
+
+  // the hulls are convex, one fan per shape
+  m_hull_buffer.clear(
+    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+  std::size_t nb_vertices = 0;
+  for (const auto &cvh : m_convex_hulls)
+    nb_vertices += cvh.size();
+  m_hull_buffer.reserve(nb_vertices, 3 * nb_vertices);
   for (std::size_t sidx = 0; sidx < m_convex_hulls.size(); ++sidx) {
     const auto &cvh = m_convex_hulls[sidx];
     const std::size_t cidx = m_shape_colors[sidx];
-    ::glColor4ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx), 150);
-    ::glBegin(GL_POLYGON);
-    // ::glBegin(GL_LINE_LOOP);
+    const std::size_t first = m_hull_buffer.size();
     for (const auto &p : cvh)
-      ::glVertex3d(p.x(), p.y(), p.z());
-    ::glEnd();
+      m_hull_buffer.add_vertex(p, Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx), 150);
+    m_hull_buffer.add_triangle_fan(first, cvh.size());
   }
+  // any prefix of the triangles is spread over the shapes
+  m_hull_buffer.shuffle_primitives(3);
+}
+
+void Horizontal_plane_detection::draw(const Point_view &view, const std::size_t max_triangles)
+{
+  if (m_points.empty())
+    return;
+
+  // draw point cloud with respect color
+  ::glDisable(GL_LIGHTING);
+  ::glPointSize(5.0);
+  m_point_octree.draw(m_point_buffer, view);
+
+  // draw convex hull of shape points
+  ::glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  ::glEnable(GL_BLEND);
+  ::glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  m_hull_buffer.draw_prefix(GL_TRIANGLES, max_triangles);
 }
 
 } // Algs
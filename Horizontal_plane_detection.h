@@ -9,6 +9,8 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Render_buffer.h"
+#include "Point_octree.h"
 
 namespace Algs {
 
@@ -28,7 +30,13 @@ public:
 
   const Bbox_3 &bbox() { return m_bbox; }
 
-  void draw();
+  // at most max_triangles hull triangles, 0 for no limit
+  void draw(const Point_view &view, const std::size_t max_triangles);
+
+private:
+  // labeled points and triangulated hulls to the render buffers,
+  // drawn without per point work
+  void build_buffers();
 
 private:
   Bbox_3 m_bbox;
@@ -39,9 +47,15 @@ private:
   std::vector<int> m_point_shapes;
   // shape color
   std::vector<std::size_t> m_shape_colors;
+  // points colored by shape
+  Render_buffer m_point_buffer;
+  // level of detail over the reordered point buffer
+  Point_octree m_point_octree;
 
   // convex hulls of shape points
   std::vector<std::vector<Kernel2::Point_3>> m_convex_hulls;
+  // hull fans of all shapes, colored by shape
+  Render_buffer m_hull_buffer;
 };
 
 } // namespace Algs
@@ -60,6 +60,7 @@ void Mainwindow::open(QString filename)
       QSettings settings;
       settings.setValue("OFF open directory", fileinfo.absoluteDir().absolutePath());
       addToRecentFiles(filename);
+      updateLodSlider();
 
       // update bbox
       updateViewerBBox();
@@ -70,6 +71,15 @@ void Mainwindow::open(QString filename)
   QApplication::restoreOverrideCursor();
 }
 
+void Mainwindow::updateLodSlider()
+{
+  // slider over the vertex splits of the progressive mesh, if any
+  const int nb_splits = static_cast<int>(scene->nb_vertex_splits());
+  lod_slider->setEnabled(nb_splits != 0);
+  lod_slider->setRange(0, nb_splits);
+  lod_slider->setValue(nb_splits);
+}
+
 void Mainwindow::readSettings()
 {
   this->readState("Mainwindow", Size|State);
@@ -101,7 +111,7 @@ void Mainwindow::on_actionLoadPolyhedron_triggered()
     tr("Load polyhedron..."),
     settings.value("off_open_directory", ".").toString(),
     tr("OFF files (*.off)\nAll files (*)"));
-  if (!filename.isEmpty())
+  if (filename.isEmpty())
     return;
   settings.setValue("off_open_directory", filename);
 
@@ -139,12 +149,65 @@ void Mainwindow::on_actionSurface_simplification_triggered()
     return;
   settings.setValue("surface_simplification_open_directory", filename);
 
+  Settings_dialog dial;
+  dial.surface_simplification->setEnabled(true);
+  if (dial.exec() != QDialog::Accepted)
+    return;
+
   QApplication::setOverrideCursor(Qt::WaitCursor);
+  Params::Surface_simplification params{
+    static_cast<Params::Surface_simplification::Stop>(dial.surface_simplification_stop->currentIndex()),
+    static_cast<std::size_t>(dial.surface_simplification_nb_faces->value()),
+    dial.surface_simplification_ratio->value(),
+    dial.surface_simplification_max_error->value(),
+    dial.surface_simplification_lindstrom_turk->isChecked(),
+    static_cast<std::size_t>(dial.surface_simplification_region_faces->value()),
+    static_cast<unsigned int>(dial.surface_simplification_cluster_resolution->value()),
+    static_cast<unsigned int>(dial.surface_simplification_nb_lods->value()),
+    dial.surface_simplification_progressive->isChecked(),
+    static_cast<std::size_t>(dial.surface_simplification_memory_budget->value()),
+    static_cast<std::size_t>(dial.surface_simplification_error_samples->value())};
+
+  // progress in the status bar, repainted as the event loop is blocked
+  scene->surface_simplification(filename.toStdString(), params,
+    [this](const std::string &msg) {
+      statusBar()->showMessage(QString::fromStdString(msg));
+      statusBar()->repaint();
+    });
+
+  // the simplified mesh, or its levels of detail, replace the loaded one
+  updateLodSlider();
+  updateViewerBBox();
+  viewer->update();
+  QApplication::restoreOverrideCursor();
+}
 
-  scene->surface_simplification(filename.toStdString());
+void Mainwindow::on_actionVertex_clustering_triggered()
+{
+  QSettings settings;
+  const QString filename = QFileDialog::getOpenFileName(
+    this,
+    tr("Load surface mesh..."),
+    settings.value("vertex_clustering_open_directory", ".").toString(),
+    tr("OFF files (*.off)"));
+  if (filename.isEmpty())
+    return;
+  settings.setValue("vertex_clustering_open_directory", filename);
+
+  Settings_dialog dial;
+  dial.vertex_clustering->setEnabled(true);
+  if (dial.exec() != QDialog::Accepted)
+    return;
 
-  // updateViewerBBox();
-  // viewer->update();
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  Params::Vertex_clustering params{
+    static_cast<unsigned int>(dial.vertex_clustering_resolution->value())};
+
+  scene->vertex_clustering(filename.toStdString(), params);
+
+  updateLodSlider();
+  updateViewerBBox();
+  viewer->update();
   QApplication::restoreOverrideCursor();
 }
 
@@ -175,6 +238,7 @@ void Mainwindow::on_actionShape_detection_triggered()
 
   scene->shape_detection(filename.toStdString(), params);
 
+  updateLodSlider();
   updateViewerBBox();
   viewer->update();
   QApplication::restoreOverrideCursor();
@@ -207,6 +271,7 @@ void Mainwindow::on_actionHorizontal_plane_detection_triggered()
 
   scene->horizontal_plane_detection(filename.toStdString(), params);
 
+  updateLodSlider();
   updateViewerBBox();
   viewer->update();
   QApplication::restoreOverrideCursor();
@@ -239,6 +304,7 @@ void Mainwindow::on_actionUnit_normal_detection_triggered()
 
   scene->unit_normal_detection(filename.toStdString(), params);
 
+  updateLodSlider();
   updateViewerBBox();
   viewer->update();
   QApplication::restoreOverrideCursor();
@@ -275,6 +341,7 @@ void Mainwindow::on_actionSymmetric_normal_detection_triggered()
     params,
     dial.snormal_detection_is_constrained->isChecked());
 
+  updateLodSlider();
   updateViewerBBox();
   viewer->update();
   QApplication::restoreOverrideCursor();
@@ -292,21 +359,52 @@ void Mainwindow::on_actionRidge_detection_triggered()
     return;
   settings.setValue("ridge_detection_open_directory", filename);
 
-  // Settings_dialog dial;
-  // dial.shape_detection->setEnabled(true);
-  // if (dial.exec() != QDialog::Accepted)
-  //   return;
+  Settings_dialog dial;
+  dial.ridge_detection->setEnabled(true);
+  if (dial.exec() != QDialog::Accepted)
+    return;
+
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  Params::Ridge_detection params{
+    static_cast<unsigned int>(dial.ridge_detection_nb_rings->value()),
+    static_cast<unsigned int>(dial.ridge_detection_nb_points->value()),
+    static_cast<unsigned int>(dial.ridge_detection_nb_scales->value()),
+    dial.ridge_detection_umb_size->value(),
+    static_cast<unsigned int>(dial.ridge_detection_patch_size->value())};
+
+  scene->ridge_detection(filename.toStdString(), params);
+
+  updateLodSlider();
+  updateViewerBBox();
+  viewer->update();
+  QApplication::restoreOverrideCursor();
+}
+
+void Mainwindow::on_actionPoint_ridge_detection_triggered()
+{
+  QSettings settings;
+  const QString filename = QFileDialog::getOpenFileName(
+    this,
+    tr("Open point with normal"),
+    settings.value("point_ridge_detection_open_directory", ".").toString(),
+    tr("Point Cloud With Normal (*.ply *.pwn)"));
+  if (filename.isEmpty())
+    return;
+  settings.setValue("point_ridge_detection_open_directory", filename);
+
+  Settings_dialog dial;
+  dial.pridge_detection->setEnabled(true);
+  if (dial.exec() != QDialog::Accepted)
+    return;
 
   QApplication::setOverrideCursor(Qt::WaitCursor);
-  // Params::Shape_detection params{
-  //   dial.shape_detection_probability->value(),
-  //   static_cast<std::size_t>(dial.shape_detection_min_points->value()),
-  //   dial.shape_detection_epsilon->value(),
-  //   dial.shape_detection_cluster_epsilon->value(),
-  //   dial.shape_detection_normal_threshold->value()};
+  Params::Point_ridge_detection params{
+    static_cast<std::size_t>(dial.pridge_detection_nb_neighbors->value()),
+    dial.pridge_detection_sharpness_ratio->value()};
 
-  scene->ridge_detection(filename.toStdString());
+  scene->point_ridge_detection(filename.toStdString(), params);
 
+  updateLodSlider();
   updateViewerBBox();
   viewer->update();
   QApplication::restoreOverrideCursor();
@@ -318,6 +416,18 @@ void Mainwindow::on_actionView_polyhedron_triggered()
   viewer->update();
 }
 
+void Mainwindow::on_actionView_statistics_triggered()
+{
+  viewer->toggle_statistics();
+  viewer->update();
+}
+
+void Mainwindow::on_lod_slider_valueChanged(int value)
+{
+  scene->set_progressive_level(static_cast<std::size_t>(value));
+  viewer->update();
+}
+
 void Mainwindow::connectActions()
 {
   // connects actionQuit (Ctrl+Q) and qApp->quit()
@@ -40,17 +40,25 @@ protected slots:
 
   // algorithm menu
   void on_actionSurface_simplification_triggered();
+  void on_actionVertex_clustering_triggered();
   void on_actionShape_detection_triggered();
   void on_actionHorizontal_plane_detection_triggered();
   void on_actionUnit_normal_detection_triggered();
   void on_actionSymmetric_normal_detection_triggered();
   void on_actionRidge_detection_triggered();
+  void on_actionPoint_ridge_detection_triggered();
 
   // view menu
   void on_actionView_polyhedron_triggered();
+  void on_actionView_statistics_triggered();
+
+  // progressive mesh resolution
+  void on_lod_slider_valueChanged(int value);
 
 private:
   void connectActions();
+  // enabled over the progressive mesh of the scene only
+  void updateLodSlider();
 
 private:
   Scene *scene;
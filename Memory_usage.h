@@ -0,0 +1,44 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <unistd.h>
+#endif
+
+/*!
+ * \brief Resident memory of the current process in bytes, 0 if unknown.
+ */
+inline std::size_t current_memory_usage()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return static_cast<std::size_t>(pmc.WorkingSetSize);
+  return 0;
+#else
+  std::ifstream ifs("/proc/self/statm");
+  std::size_t size = 0, resident = 0;
+  if (!(ifs >> size >> resident))
+    return 0;
+  return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/*!
+ * \brief Bytes to mega bytes, for reports.
+ */
+inline double to_mb(const std::size_t bytes)
+{
+  return double(bytes) / (1024.0 * 1024.0);
+}
+
+#endif // MEMORY_USAGE_H
@@ -0,0 +1,181 @@
+#include "Mesh_error.h"
+#include "Off_reader.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include <CGAL/AABB_tree.h>
+#include <CGAL/AABB_traits.h>
+#include <CGAL/AABB_triangle_primitive.h>
+
+typedef std::vector<Triangle_3>::const_iterator Triangle_iterator;
+typedef CGAL::AABB_triangle_primitive<Kernel, Triangle_iterator> Aabb_primitive;
+typedef CGAL::AABB_traits<Kernel, Aabb_primitive> Aabb_traits;
+typedef CGAL::AABB_tree<Aabb_traits> Aabb_tree;
+
+static bool read_triangles(
+  const std::string &fname,
+  std::vector<Point_3> &points,
+  std::vector<Mesh_error::Triangle> &triangles)
+{
+  Off_reader reader;
+  if (!reader.open(fname))
+    return false;
+
+  points.resize(reader.nb_vertices());
+  for (Point_3 &p : points) {
+    double xyz[3];
+    if (!reader.read_vertex(xyz))
+      return false;
+    p = Point_3(xyz[0], xyz[1], xyz[2]);
+  }
+
+  triangles.clear();
+  triangles.reserve(reader.nb_faces());
+  std::vector<std::size_t> face;
+  for (std::size_t f = 0; f < reader.nb_faces(); ++f) {
+    if (!reader.read_face(face))
+      return false;
+    for (const std::size_t v : face)
+      if (v >= points.size())
+        return false;
+    for (std::size_t j = 1; j + 1 < face.size(); ++j) {
+      const Mesh_error::Triangle t = {face[0], face[j], face[j + 1]};
+      triangles.push_back(t);
+    }
+  }
+
+  return true;
+}
+
+/*!
+ * \brief Largest and root mean square distances from the surface a to the surface b.
+ */
+static void one_sided_error(
+  const std::vector<Point_3> &points_a,
+  const std::vector<Mesh_error::Triangle> &triangles_a,
+  const std::vector<Point_3> &points_b,
+  const std::vector<Mesh_error::Triangle> &triangles_b,
+  const std::size_t nb_samples,
+  double &max_distance,
+  double &rms_distance)
+{
+  max_distance = 0.0;
+  rms_distance = 0.0;
+  if (triangles_a.empty() || triangles_b.empty())
+    return;
+
+  std::vector<Triangle_3> surface_b(triangles_b.size());
+  Algs::parallel_for(triangles_b.size(), [&](const std::size_t i) {
+    const Mesh_error::Triangle &t = triangles_b[i];
+    surface_b[i] = Triangle_3(points_b[t[0]], points_b[t[1]], points_b[t[2]]);
+  });
+  // built before the concurrent queries, the tree is built lazily otherwise
+  Aabb_tree tree(surface_b.begin(), surface_b.end());
+  tree.build();
+  tree.accelerate_distance_queries();
+
+  // samples per face in proportion to its area, the fractional part is
+  // drawn with a generator seeded by the face so that runs are repeatable
+  const std::size_t nb_faces = triangles_a.size();
+  std::vector<double> areas(nb_faces);
+  Algs::parallel_for(nb_faces, [&](const std::size_t i) {
+    const Mesh_error::Triangle &t = triangles_a[i];
+    areas[i] = std::sqrt(CGAL::squared_area(points_a[t[0]], points_a[t[1]], points_a[t[2]]));
+  });
+  double total_area = 0.0;
+  for (const double a : areas)
+    total_area += a;
+  if (total_area <= 0.0)
+    return;
+
+  std::vector<std::size_t> offsets(nb_faces + 1, 0);
+  Algs::parallel_for(nb_faces, [&](const std::size_t i) {
+    const double expected = areas[i] / total_area * double(nb_samples);
+    std::minstd_rand rng(static_cast<std::minstd_rand::result_type>(i + 1));
+    const double fraction = expected - std::floor(expected);
+    offsets[i + 1] = std::size_t(expected)
+      + (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < fraction ? 1 : 0);
+  });
+  for (std::size_t i = 0; i < nb_faces; ++i)
+    offsets[i + 1] += offsets[i];
+
+  // the vertices are measured too, they weigh nothing in the mean
+  const std::size_t nb_face_samples = offsets[nb_faces];
+  std::vector<double> squared_distances(nb_face_samples + points_a.size());
+  std::vector<double> weights(nb_face_samples, 0.0);
+  Algs::parallel_for(nb_faces, [&](const std::size_t i) {
+    const std::size_t n = offsets[i + 1] - offsets[i];
+    if (n == 0)
+      return;
+    const Mesh_error::Triangle &t = triangles_a[i];
+    const Point_3 &p0 = points_a[t[0]];
+    const Point_3 &p1 = points_a[t[1]];
+    const Point_3 &p2 = points_a[t[2]];
+    std::minstd_rand rng(static_cast<std::minstd_rand::result_type>(nb_faces + i + 1));
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (std::size_t s = offsets[i]; s < offsets[i + 1]; ++s) {
+      // uniform barycentric coordinates
+      const double r1 = std::sqrt(uniform(rng));
+      const double r2 = uniform(rng);
+      const Point_3 p = CGAL::barycenter(p0, 1.0 - r1, p1, r1 * (1.0 - r2), p2, r1 * r2);
+      squared_distances[s] = tree.squared_distance(p);
+      weights[s] = areas[i] / double(n);
+    }
+  });
+  Algs::parallel_for(points_a.size(), [&](const std::size_t i) {
+    squared_distances[nb_face_samples + i] = tree.squared_distance(points_a[i]);
+  });
+
+  double sum = 0.0, sum_weights = 0.0, max_squared = 0.0;
+  for (std::size_t s = 0; s < squared_distances.size(); ++s)
+    max_squared = std::max(max_squared, squared_distances[s]);
+  for (std::size_t s = 0; s < nb_face_samples; ++s) {
+    sum += weights[s] * squared_distances[s];
+    sum_weights += weights[s];
+  }
+  max_distance = std::sqrt(max_squared);
+  rms_distance = sum_weights > 0.0 ? std::sqrt(sum / sum_weights) : 0.0;
+}
+
+bool Mesh_error::measure(
+  const std::string &fname_a,
+  const std::string &fname_b,
+  const std::size_t nb_samples)
+{
+  std::vector<Point_3> points_a, points_b;
+  std::vector<Triangle> triangles_a, triangles_b;
+  if (!read_triangles(fname_a, points_a, triangles_a)) {
+    std::cerr << "unable to read " << fname_a << std::endl;
+    return false;
+  }
+  if (!read_triangles(fname_b, points_b, triangles_b)) {
+    std::cerr << "unable to read " << fname_b << std::endl;
+    return false;
+  }
+
+  measure(points_a, triangles_a, points_b, triangles_b, nb_samples);
+  return true;
+}
+
+void Mesh_error::measure(
+  const std::vector<Point_3> &points_a,
+  const std::vector<Triangle> &triangles_a,
+  const std::vector<Point_3> &points_b,
+  const std::vector<Triangle> &triangles_b,
+  const std::size_t nb_samples)
+{
+  one_sided_error(points_a, triangles_a, points_b, triangles_b, nb_samples, hausdorff_ab, rms_ab);
+  one_sided_error(points_b, triangles_b, points_a, triangles_a, nb_samples, hausdorff_ba, rms_ba);
+}
+
+void Mesh_error::print(std::ostream &os) const
+{
+  os << "#hausdorff " << hausdorff()
+    << "\n#hausdorff_ab " << hausdorff_ab
+    << "\n#hausdorff_ba " << hausdorff_ba
+    << "\n#rms_ab " << rms_ab
+    << "\n#rms_ba " << rms_ba << std::endl;
+}
@@ -0,0 +1,54 @@
+#ifndef MESH_ERROR_H
+#define MESH_ERROR_H
+
+#include "types.h"
+
+#include <array>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/*!
+ * \brief Approximation error between two triangle surfaces.
+ * Points sampled uniformly on each surface, and its vertices, are projected
+ * onto the other surface with an AABB tree, the queries run in parallel.
+ */
+class Mesh_error {
+public:
+  typedef std::array<std::size_t, 3> Triangle;
+
+  Mesh_error() : hausdorff_ab(0.0), hausdorff_ba(0.0), rms_ab(0.0), rms_ba(0.0) {}
+
+  /*!
+   * \brief Measure the error between two OFF files, polygons are triangulated.
+   * Both meshes are loaded with their AABB trees, about 150 bytes per face.
+   * \return false if a file cannot be read
+   */
+  bool measure(const std::string &fname_a,
+    const std::string &fname_b,
+    const std::size_t nb_samples);
+
+  /*!
+   * \brief Measure the error between two triangle meshes.
+   */
+  void measure(const std::vector<Point_3> &points_a,
+    const std::vector<Triangle> &triangles_a,
+    const std::vector<Point_3> &points_b,
+    const std::vector<Triangle> &triangles_b,
+    const std::size_t nb_samples);
+
+  // symmetric Hausdorff distance
+  double hausdorff() const { return std::max(hausdorff_ab, hausdorff_ba); }
+
+  void print(std::ostream &os) const;
+
+  // one-sided distances, from a to b and from b to a
+  double hausdorff_ab;
+  double hausdorff_ba;
+  // root mean square distances, area weighted
+  double rms_ab;
+  double rms_ba;
+};
+
+#endif // MESH_ERROR_H
@@ -0,0 +1,184 @@
+#include "Mesh_patches.h"
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/foreach.hpp>
+#include <CGAL/boost/graph/iterator.h>
+
+void Mesh_patches::build(const Surface_mesh &mesh, const std::size_t faces_per_patch)
+{
+  const std::size_t nb_faces = mesh.number_of_faces();
+  m_face_patch.assign(nb_faces, 0);
+  m_offsets.assign(1, 0);
+  m_faces.clear();
+  if (nb_faces == 0)
+    return;
+
+  // face centroids and their bounding box
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  std::vector<Point_3> centroids(nb_faces);
+  BOOST_FOREACH(const face_descriptor f, faces(mesh)) {
+    Vector_3 sum(0.0, 0.0, 0.0);
+    std::size_t n = 0;
+    BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(halfedge(f, mesh), mesh)) {
+      sum = sum + (get(vpm, v) - CGAL::ORIGIN);
+      ++n;
+    }
+    centroids[std::size_t(f)] = CGAL::ORIGIN + sum / double(n);
+  }
+  Bbox_3 bbox = centroids.front().bbox();
+  for (const auto &c : centroids)
+    bbox += c.bbox();
+  const double extents[3] = {
+    bbox.xmax() - bbox.xmin(), bbox.ymax() - bbox.ymin(), bbox.zmax() - bbox.zmin()};
+  const double max_extent = *std::max_element(extents, extents + 3);
+
+  // largest cubic cell giving at least the required number of cells,
+  // flat models get a single layer of cells
+  const std::size_t nb_required = faces_per_patch == 0 ? 1 :
+    (nb_faces + faces_per_patch - 1) / faces_per_patch;
+  auto nb_cells_of = [&](const double cell_side, std::size_t cell_dims[3]) {
+    std::size_t nb = 1;
+    for (int i = 0; i < 3; ++i) {
+      cell_dims[i] = std::max(std::size_t(1), std::size_t(std::ceil(extents[i] / cell_side)));
+      nb *= cell_dims[i];
+    }
+    return nb;
+  };
+  std::size_t dims[3] = {1, 1, 1};
+  double side = max_extent;
+  if (nb_required > 1 && max_extent > 0.0) {
+    double lo = max_extent / double(nb_required);
+    double hi = max_extent;
+    for (int iter = 0; iter < 40; ++iter) {
+      const double mid = (lo + hi) / 2.0;
+      if (nb_cells_of(mid, dims) >= nb_required)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    side = lo;
+    nb_cells_of(side, dims);
+  }
+
+  // cell of each face
+  std::vector<std::size_t> face_cell(nb_faces, 0);
+  const double mins[3] = {bbox.xmin(), bbox.ymin(), bbox.zmin()};
+  for (std::size_t f = 0; f < nb_faces; ++f) {
+    std::size_t coords[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i)
+      if (dims[i] > 1)
+        coords[i] = std::min(dims[i] - 1,
+          std::size_t((centroids[f][i] - mins[i]) / side));
+    face_cell[f] = (coords[0] * dims[1] + coords[1]) * dims[2] + coords[2];
+  }
+
+  // non-empty cells are the patches, core faces sorted by patch
+  std::vector<std::size_t> cell_counts(dims[0] * dims[1] * dims[2], 0);
+  for (const std::size_t c : face_cell)
+    ++cell_counts[c];
+  std::vector<std::size_t> cell_patch(cell_counts.size(), 0);
+  for (std::size_t c = 0; c < cell_counts.size(); ++c) {
+    if (cell_counts[c] == 0)
+      continue;
+    cell_patch[c] = m_offsets.size() - 1;
+    m_offsets.push_back(m_offsets.back() + cell_counts[c]);
+  }
+  m_faces.resize(nb_faces);
+  std::vector<std::size_t> cursors(m_offsets.begin(), m_offsets.end() - 1);
+  for (std::size_t f = 0; f < nb_faces; ++f) {
+    const std::size_t p = cell_patch[face_cell[f]];
+    m_face_patch[f] = p;
+    m_faces[cursors[p]++] = face_descriptor(static_cast<Surface_mesh::size_type>(f));
+  }
+}
+
+void Mesh_patches::extract(
+  const Surface_mesh &mesh,
+  const std::size_t i,
+  const std::size_t halo_rings,
+  Patch &patch) const
+{
+  patch.mesh.clear();
+  patch.to_mesh.clear();
+  patch.is_core_face.clear();
+  patch.is_owned_vertex.clear();
+  patch.failed_faces.clear();
+
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  std::unordered_map<std::size_t, vertex_descriptor> to_patch;
+  auto add_vertex = [&](const vertex_descriptor v) {
+    if (to_patch.find(std::size_t(v)) != to_patch.end())
+      return false;
+    to_patch[std::size_t(v)] = patch.mesh.add_vertex(get(vpm, v));
+    patch.to_mesh.push_back(v);
+    return true;
+  };
+
+  // ring 0 is the vertices of the core faces
+  for (std::size_t j = m_offsets[i]; j < m_offsets[i + 1]; ++j)
+    BOOST_FOREACH(const vertex_descriptor v,
+      vertices_around_face(halfedge(m_faces[j], mesh), mesh))
+      add_vertex(v);
+
+  // halo rings
+  std::size_t ring_begin = 0;
+  for (std::size_t r = 0; r < halo_rings; ++r) {
+    const std::size_t ring_end = patch.to_mesh.size();
+    for (std::size_t j = ring_begin; j < ring_end; ++j) {
+      const halfedge_descriptor h = halfedge(patch.to_mesh[j], mesh);
+      if (h == boost::graph_traits<Surface_mesh>::null_halfedge())
+        continue;
+      BOOST_FOREACH(const vertex_descriptor u, vertices_around_target(h, mesh))
+        add_vertex(u);
+    }
+    if (patch.to_mesh.size() == ring_end)
+      break;
+    ring_begin = ring_end;
+  }
+
+  // core faces first, then the halo faces having all their vertices in the patch
+  std::vector<vertex_descriptor> face_vertices;
+  auto add_face = [&](const face_descriptor f, const bool is_core) {
+    face_vertices.clear();
+    BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(halfedge(f, mesh), mesh)) {
+      const auto it = to_patch.find(std::size_t(v));
+      if (it == to_patch.end())
+        return;
+      face_vertices.push_back(it->second);
+    }
+    if (patch.mesh.add_face(face_vertices) == Surface_mesh::null_face())
+      patch.failed_faces.push_back(f);
+    else
+      patch.is_core_face.push_back(is_core ? 1 : 0);
+  };
+  for (std::size_t j = m_offsets[i]; j < m_offsets[i + 1]; ++j)
+    add_face(m_faces[j], true);
+
+  std::unordered_set<std::size_t> halo_faces;
+  for (std::size_t j = 0; halo_rings != 0 && j < patch.to_mesh.size(); ++j) {
+    const halfedge_descriptor h = halfedge(patch.to_mesh[j], mesh);
+    if (h == boost::graph_traits<Surface_mesh>::null_halfedge())
+      continue;
+    BOOST_FOREACH(const face_descriptor f, faces_around_target(h, mesh)) {
+      if (f == boost::graph_traits<Surface_mesh>::null_face()
+        || m_face_patch[std::size_t(f)] == i
+        || !halo_faces.insert(std::size_t(f)).second)
+        continue;
+      add_face(f, false);
+    }
+  }
+
+  // a vertex is owned by the patch of the face of its halfedge
+  patch.is_owned_vertex.reserve(patch.to_mesh.size());
+  for (const vertex_descriptor v : patch.to_mesh) {
+    halfedge_descriptor h = halfedge(v, mesh);
+    if (mesh.is_border(h))
+      h = opposite(h, mesh);
+    patch.is_owned_vertex.push_back(
+      m_face_patch[std::size_t(face(h, mesh))] == i ? 1 : 0);
+  }
+}
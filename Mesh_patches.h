@@ -0,0 +1,63 @@
+#ifndef MESH_PATCHES_H
+#define MESH_PATCHES_H
+
+#include "types.h"
+
+#include <vector>
+
+/*!
+ * \brief Spatial partition of the faces of a Surface_mesh into patches.
+ * Faces are binned to a uniform grid by their centroid, each non-empty cell
+ * is a patch. A patch is extracted as a standalone mesh with halo rings
+ * around its core faces, so that neighborhood based computations on the
+ * core are the same as on the whole mesh.
+ */
+class Mesh_patches {
+public:
+  /*!
+   * \brief A patch extracted as a standalone mesh.
+   */
+  struct Patch {
+    Surface_mesh mesh;
+    // original vertex of each patch vertex
+    std::vector<vertex_descriptor> to_mesh;
+    // core faces belong to the patch, the others to the halo
+    std::vector<char> is_core_face;
+    // each vertex of the mesh is owned by exactly one patch
+    std::vector<char> is_owned_vertex;
+    // original faces not added to the patch because of non-manifold borders
+    std::vector<face_descriptor> failed_faces;
+  };
+
+  Mesh_patches() {}
+
+  /*!
+   * \brief Partition the mesh into patches of about faces_per_patch faces.
+   */
+  void build(const Surface_mesh &mesh, const std::size_t faces_per_patch);
+
+  // number of patches
+  std::size_t size() const { return m_offsets.size() - 1; }
+
+  // number of core faces of patch i
+  std::size_t nb_faces(const std::size_t i) const { return m_offsets[i + 1] - m_offsets[i]; }
+
+  /*!
+   * \brief Extract patch i with halo_rings vertex rings around its core faces,
+   * 0 extracts the core faces only.
+   * Only reads the mesh, safe to run concurrently on different patches.
+   */
+  void extract(const Surface_mesh &mesh,
+    const std::size_t i,
+    const std::size_t halo_rings,
+    Patch &patch) const;
+
+private:
+  // patch of each face
+  std::vector<std::size_t> m_face_patch;
+  // core faces of patch i at [m_offsets[i], m_offsets[i + 1])
+  std::vector<std::size_t> m_offsets;
+  std::vector<face_descriptor> m_faces;
+};
+
+#endif // MESH_PATCHES_H
@@ -0,0 +1,56 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/*!
+ * \brief Single owner of the heap objects CGAL approximators hand out as raw pointers.
+ * Every object pushed through inserter() is released in one shot by clear()
+ * or the destructor, whether it was consumed or filtered out by the caller.
+ */
+template <typename T>
+class Object_pool {
+public:
+  typedef std::vector<T *> Container;
+  typedef typename Container::const_iterator const_iterator;
+
+  Object_pool() {}
+
+  ~Object_pool() { clear(); }
+
+  // the pool is the only owner, no copy
+  Object_pool(const Object_pool &) = delete;
+  Object_pool &operator=(const Object_pool &) = delete;
+
+  // output iterator to pass to the CGAL compute functions
+  std::back_insert_iterator<Container> inserter() {
+    return std::back_inserter(m_objects);
+  }
+
+  const_iterator begin() const { return m_objects.begin(); }
+
+  const_iterator end() const { return m_objects.end(); }
+
+  const T *operator[](const std::size_t i) const { return m_objects[i]; }
+
+  std::size_t size() const { return m_objects.size(); }
+
+  // object shells and pointer table, excluding memory owned by the objects
+  std::size_t bytes() const {
+    return m_objects.size() * sizeof(T) + m_objects.capacity() * sizeof(T *);
+  }
+
+  // release all objects at once
+  void clear() {
+    for (T *p : m_objects)
+      delete p;
+    Container().swap(m_objects);
+  }
+
+private:
+  Container m_objects;
+};
+
+#endif // OBJECT_POOL_H
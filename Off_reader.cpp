@@ -0,0 +1,44 @@
+#include "Off_reader.h"
+
+#include <limits>
+
+bool Off_reader::open(const std::string &fname)
+{
+  m_ifs.open(fname);
+  if (!m_ifs.is_open())
+    return false;
+
+  std::string header;
+  std::size_t nb_edges = 0;
+  skip_comments();
+  m_ifs >> header;
+  skip_comments();
+  m_ifs >> m_nb_vertices >> m_nb_faces >> nb_edges;
+  return m_ifs && header.size() >= 3 && header.substr(header.size() - 3) == "OFF";
+}
+
+bool Off_reader::read_vertex(double *p)
+{
+  skip_comments();
+  m_ifs >> p[0] >> p[1] >> p[2];
+  m_ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  return bool(m_ifs);
+}
+
+bool Off_reader::read_face(std::vector<std::size_t> &face)
+{
+  std::size_t degree = 0;
+  skip_comments();
+  m_ifs >> degree;
+  face.resize(degree);
+  for (std::size_t j = 0; j < degree; ++j)
+    m_ifs >> face[j];
+  m_ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  return bool(m_ifs);
+}
+
+void Off_reader::skip_comments()
+{
+  while (m_ifs >> std::ws && m_ifs.peek() == '#')
+    m_ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
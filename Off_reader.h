@@ -0,0 +1,42 @@
+#ifndef OFF_READER_H
+#define OFF_READER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+/*!
+ * \brief Sequential reader of an OFF file, records are read one at a time
+ * so that the file never needs to fit in memory. Colors and normals after
+ * the coordinates, and after the face indices, are skipped.
+ */
+class Off_reader {
+public:
+  Off_reader() : m_nb_vertices(0), m_nb_faces(0) {}
+
+  /*!
+   * \brief Open the file and read its header.
+   */
+  bool open(const std::string &fname);
+
+  std::size_t nb_vertices() const { return m_nb_vertices; }
+
+  std::size_t nb_faces() const { return m_nb_faces; }
+
+  // the vertices are read first, then the faces
+  bool read_vertex(double *p);
+  bool read_face(std::vector<std::size_t> &face);
+
+  void close() { m_ifs.close(); }
+
+private:
+  // skip white spaces and # comment lines
+  void skip_comments();
+
+private:
+  std::ifstream m_ifs;
+  std::size_t m_nb_vertices;
+  std::size_t m_nb_faces;
+};
+
+#endif // OFF_READER_H
@@ -0,0 +1,35 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#endif
+
+namespace Algs {
+
+/*!
+ * \brief Calls f(i) for every i in [0, n), concurrently when TBB is available.
+ * f must only write to data owned by index i, so results gathered
+ * by index come out in the same order as a serial loop.
+ */
+template <typename Function>
+void parallel_for(const std::size_t n, const Function &f)
+{
+#ifdef CGAL_LINKED_WITH_TBB
+  tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n),
+    [&f](const tbb::blocked_range<std::size_t> &r) {
+      for (std::size_t i = r.begin(); i != r.end(); ++i)
+        f(i);
+    });
+#else
+  for (std::size_t i = 0; i < n; ++i)
+    f(i);
+#endif
+}
+
+} // namespace Algs
+
+#endif // PARALLEL_H
@@ -0,0 +1,188 @@
+#include "Point_octree.h"
+
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <limits>
+#include <cmath>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <gl/gl.h>
+
+// projected pixels per drawn point before a node is refined
+const double pixels_per_point = 4.0;
+// deeper nodes would only split duplicated points
+const unsigned int max_depth = 20;
+
+void Point_octree::build(Render_buffer &buffer, const std::size_t node_size)
+{
+  m_nodes.clear();
+  if (buffer.empty() || node_size == 0)
+    return;
+
+  // cubic root around the points
+  const double *origin = buffer.origin();
+  double bmin[3], bmax[3];
+  for (int k = 0; k < 3; ++k) {
+    bmin[k] = std::numeric_limits<double>::max();
+    bmax[k] = -std::numeric_limits<double>::max();
+  }
+  for (std::size_t i = 0; i < buffer.size(); ++i) {
+    const float *p = buffer.vertex(i).position;
+    for (int k = 0; k < 3; ++k) {
+      bmin[k] = std::min(bmin[k], double(p[k]));
+      bmax[k] = std::max(bmax[k], double(p[k]));
+    }
+  }
+  double center[3];
+  double half_size = 0.0;
+  for (int k = 0; k < 3; ++k) {
+    center[k] = origin[k] + (bmin[k] + bmax[k]) / 2.0;
+    half_size = std::max(half_size, (bmax[k] - bmin[k]) / 2.0);
+  }
+
+  std::vector<std::uint32_t> order(buffer.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+    order[i] = std::uint32_t(i);
+  build_node(buffer, order, 0, order.size(), center, half_size, node_size, 0);
+  buffer.reorder(order);
+}
+
+std::uint32_t Point_octree::build_node(
+  const Render_buffer &buffer,
+  std::vector<std::uint32_t> &order,
+  const std::size_t first,
+  const std::size_t last,
+  const double center[3],
+  const double half_size,
+  const std::size_t node_size,
+  const unsigned int depth)
+{
+  const std::uint32_t nidx = std::uint32_t(m_nodes.size());
+  m_nodes.push_back(Node());
+  {
+    Node &node = m_nodes.back();
+    for (int k = 0; k < 3; ++k)
+      node.center[k] = center[k];
+    node.half_size = half_size;
+    node.first = std::uint32_t(first);
+    std::fill(node.children, node.children + 8, 0);
+  }
+
+  // the owned points are a random subset, same seed for the same cloud
+  std::mt19937 rng(nidx);
+  std::shuffle(order.begin() + first, order.begin() + last, rng);
+  if (last - first <= node_size || depth == max_depth) {
+    m_nodes[nidx].count = std::uint32_t(last - first);
+    return nidx;
+  }
+  m_nodes[nidx].count = std::uint32_t(node_size);
+
+  // the other points to octants, sorted by x, y then z half
+  const double *origin = buffer.origin();
+  const auto octant = [&](const std::uint32_t i) {
+    const float *p = buffer.vertex(i).position;
+    return (origin[0] + p[0] < center[0] ? 0 : 4)
+      + (origin[1] + p[1] < center[1] ? 0 : 2)
+      + (origin[2] + p[2] < center[2] ? 0 : 1);
+  };
+  std::stable_sort(order.begin() + first + node_size, order.begin() + last,
+    [&](const std::uint32_t a, const std::uint32_t b) { return octant(a) < octant(b); });
+
+  std::size_t begin = first + node_size;
+  while (begin < last) {
+    const int o = octant(order[begin]);
+    std::size_t end = begin + 1;
+    while (end < last && octant(order[end]) == o)
+      ++end;
+
+    const double child_half_size = half_size / 2.0;
+    const double child_center[3] = {
+      center[0] + (o & 4 ? child_half_size : -child_half_size),
+      center[1] + (o & 2 ? child_half_size : -child_half_size),
+      center[2] + (o & 1 ? child_half_size : -child_half_size)};
+    const std::uint32_t child = build_node(
+      buffer, order, begin, end, child_center, child_half_size, node_size, depth + 1);
+    m_nodes[nidx].children[o] = child;
+    begin = end;
+  }
+
+  return nidx;
+}
+
+std::size_t Point_octree::draw(
+  Render_buffer &buffer,
+  const Point_view &view,
+  const bool with_normals) const
+{
+  if (m_nodes.empty())
+    return 0;
+
+  const std::size_t budget = view.point_budget == 0 ?
+    std::numeric_limits<std::size_t>::max() : view.point_budget;
+
+  // largest projected nodes first, so that the budget goes to the closest
+  typedef std::pair<double, std::uint32_t> Queued;
+  std::priority_queue<Queued> queue;
+  if (is_visible(m_nodes.front(), view))
+    queue.push(Queued(screen_size(m_nodes.front(), view), 0));
+
+  std::vector<int> firsts;
+  std::vector<int> counts;
+  std::size_t nb_points = 0;
+  while (!queue.empty() && nb_points < budget) {
+    const double size = queue.top().first;
+    const Node &node = m_nodes[queue.top().second];
+    queue.pop();
+
+    // a prefix of the owned points is still a uniform sample
+    const std::size_t count = std::min(std::size_t(node.count), budget - nb_points);
+    firsts.push_back(int(node.first));
+    counts.push_back(int(count));
+    nb_points += count;
+
+    if (size * size <= pixels_per_point * double(node.count))
+      continue;
+    for (const std::uint32_t c : node.children) {
+      if (c != 0 && is_visible(m_nodes[c], view))
+        queue.push(Queued(screen_size(m_nodes[c], view), c));
+    }
+  }
+
+  buffer.draw(GL_POINTS, firsts, counts, with_normals);
+  return nb_points;
+}
+
+bool Point_octree::is_visible(const Node &node, const Point_view &view) const
+{
+  // out if the corner deepest inside a plane is still outside
+  for (int i = 0; i < 6; ++i) {
+    const double *plane = view.planes[i];
+    double distance = -plane[3];
+    for (int k = 0; k < 3; ++k)
+      distance += plane[k] * (node.center[k]
+        + (plane[k] > 0.0 ? -node.half_size : node.half_size));
+    if (distance > 0.0)
+      return false;
+  }
+  return true;
+}
+
+double Point_octree::screen_size(const Node &node, const Point_view &view) const
+{
+  const double diameter = 2.0 * std::sqrt(3.0) * node.half_size;
+  if (!view.is_perspective)
+    return view.pixel_size > 0.0 ? diameter / view.pixel_size
+      : std::numeric_limits<double>::max();
+
+  // nodes around the eye are always refined
+  double depth = 0.0;
+  for (int k = 0; k < 3; ++k)
+    depth += (node.center[k] - view.eye[k]) * view.view_direction[k];
+  depth -= std::sqrt(3.0) * node.half_size;
+  if (depth <= 0.0 || view.pixel_size <= 0.0)
+    return std::numeric_limits<double>::max();
+  return diameter / (view.pixel_size * depth);
+}
@@ -0,0 +1,99 @@
+#ifndef POINT_OCTREE_H
+#define POINT_OCTREE_H
+
+#include "Render_buffer.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * \brief Camera state for the point level of detail, filled by the viewer
+ * each frame. Frustum planes are a * x + b * y + c * z = d with the normals
+ * pointing outside.
+ */
+struct Point_view {
+  Point_view() : is_perspective(true), pixel_size(0.0), point_budget(0) {
+    for (int i = 0; i < 6; ++i)
+      planes[i][0] = planes[i][1] = planes[i][2] = planes[i][3] = 0.0;
+    eye[0] = eye[1] = eye[2] = 0.0;
+    view_direction[0] = view_direction[1] = 0.0;
+    view_direction[2] = -1.0;
+  }
+
+  double planes[6][4];
+  double eye[3];
+  double view_direction[3];
+  bool is_perspective;
+  // size of a pixel in world units, at unit depth if perspective
+  double pixel_size;
+  // maximum number of points drawn per cloud and frame, 0 for no limit
+  std::size_t point_budget;
+};
+
+/*!
+ * \brief Octree over the points of a render buffer, for view dependent
+ * level of detail. The buffer is reordered so that each node owns a
+ * contiguous range: a random subset of its points for an inner node, the
+ * remaining points for a leaf. Any prefix of a range is then a uniform
+ * sample of the node. A frame draws the visible nodes from the root down,
+ * refining a node while its points are sparser than pixels_per_point
+ * projected pixels each, within the point budget.
+ */
+class Point_octree {
+  struct Node {
+    // cube of the node in world coordinates
+    double center[3];
+    double half_size;
+    // range of the points owned by the node in the buffer
+    std::uint32_t first;
+    std::uint32_t count;
+    // child node of each octant, 0 if empty since the root is no child
+    std::uint32_t children[8];
+  };
+
+public:
+  Point_octree() {}
+
+  /*!
+   * \brief Reorder the unindexed points of the buffer and build the nodes
+   * over them, a node owns at most node_size points.
+   */
+  void build(Render_buffer &buffer, const std::size_t node_size = 4096);
+
+  void clear() { m_nodes.clear(); }
+
+  bool empty() const { return m_nodes.empty(); }
+
+  std::size_t size() const { return m_nodes.size(); }
+
+  /*!
+   * \brief Draw the points of the buffer seen from the view as GL_POINTS.
+   * \return the number of points drawn
+   */
+  std::size_t draw(Render_buffer &buffer,
+    const Point_view &view,
+    const bool with_normals = false) const;
+
+private:
+  // node over [first, last) of the order, whose points are shuffled
+  std::uint32_t build_node(
+    const Render_buffer &buffer,
+    std::vector<std::uint32_t> &order,
+    const std::size_t first,
+    const std::size_t last,
+    const double center[3],
+    const double half_size,
+    const std::size_t node_size,
+    const unsigned int depth);
+
+  bool is_visible(const Node &node, const Point_view &view) const;
+
+  // projected node diameter in pixels
+  double screen_size(const Node &node, const Point_view &view) const;
+
+private:
+  std::vector<Node> m_nodes;
+};
+
+#endif // POINT_OCTREE_H
@@ -0,0 +1,217 @@
+#include "Point_ridge_detection.h"
+#include "Parallel.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#include <CGAL/IO/read_xyz_points.h>
+#include <CGAL/IO/read_ply_points.h>
+
+#include <CGAL/property_map.h>
+#include <CGAL/Search_traits_3.h>
+#include <CGAL/Search_traits_adapter.h>
+#include <CGAL/Orthogonal_k_neighbor_search.h>
+#include <CGAL/Monge_via_jet_fitting.h>
+
+#include <boost/tuple/tuple.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <gl/gl.h>
+#include "Color_256.h"
+
+// kNN search on points carrying their index
+typedef boost::tuple<Point_3, std::size_t> Point_and_index;
+typedef CGAL::Search_traits_3<Kernel> Knn_traits_base;
+typedef CGAL::Search_traits_adapter<Point_and_index,
+  CGAL::Nth_of_tuple_property_map<0, Point_and_index>,
+  Knn_traits_base> Knn_traits;
+typedef CGAL::Orthogonal_k_neighbor_search<Knn_traits> Knn_search;
+typedef Knn_search::Tree Knn_tree;
+
+typedef CGAL::Monge_via_jet_fitting<Kernel> Monge_via_jet_fitting;
+typedef Monge_via_jet_fitting::Monge_form Monge_form;
+
+// jet fitting degrees, 2 is enough for curvatures
+const unsigned int d_fitting = 2;
+const unsigned int d_monge = 2;
+const std::size_t min_nb_points = (d_fitting + 1) * (d_fitting + 2) / 2;
+
+// neighbors within this angle of the maximal curvature direction
+// are compared for the non-maximum suppression of sharp points, 45 degrees
+const double sharp_cone_cos = 0.70710678118654752440;
+
+namespace Algs {
+
+void Point_ridge_detection::detect(
+  const std::string &fname,
+  const Params::Point_ridge_detection &params)
+{
+  typedef CGAL::First_of_pair_property_map<Point_with_normal>  Point_map;
+  typedef CGAL::Second_of_pair_property_map<Point_with_normal> Normal_map;
+
+  m_points.clear();
+  // Loads point set from a file.
+  std::ifstream ifs(fname);
+  if (!ifs.is_open())
+    return;
+  bool is_successful = false;
+  if (fname.substr(fname.find_last_of('.')) == ".pwn")
+    is_successful = CGAL::read_xyz_points_and_normals(
+      ifs, std::back_inserter(m_points), Point_map(), Normal_map());
+  else if (fname.substr(fname.find_last_of('.')) == ".ply")
+    is_successful = CGAL::read_ply_points_and_normals(
+      ifs, std::back_inserter(m_points), Point_map(), Normal_map());
+  ifs.close();
+  if (!is_successful) {
+    std::cerr << "Error: cannot read file " << fname << std::endl;
+    return;
+  }
+
+  const std::size_t nb_points = m_points.size();
+  const std::size_t k = std::min(std::max(params.nb_neighbors, min_nb_points), nb_points);
+  if (k < min_nb_points) {
+    std::cerr << "not enough points in the model" << std::endl;
+    m_points.clear();
+    return;
+  }
+
+  // update viewing bbox
+  m_bbox = m_points.front().first.bbox();
+  for (auto &p : m_points)
+    m_bbox = m_bbox + p.first.bbox();
+
+  // spatial index, built before the concurrent queries
+  std::cout << "Build kNN graph, k = " << k << "..." << std::endl;
+  std::vector<Point_and_index> indexed_points;
+  indexed_points.reserve(nb_points);
+  for (std::size_t i = 0; i < nb_points; ++i)
+    indexed_points.push_back(Point_and_index(m_points[i].first, i));
+  Knn_tree tree(indexed_points.begin(), indexed_points.end());
+  tree.build();
+
+  // kNN graph, k neighbors of point i at [i * k, (i + 1) * k), nearest first
+  std::vector<std::size_t> knn(nb_points * k);
+  Algs::parallel_for(nb_points, [&](const std::size_t i) {
+    Knn_search search(tree, m_points[i].first, static_cast<unsigned int>(k));
+    std::size_t *out = knn.data() + i * k;
+    std::size_t n = 0;
+    for (auto it = search.begin(); it != search.end() && n < k; ++it)
+      out[n++] = boost::get<1>(it->first);
+    // fewer neighbors than required only with duplicated queries, repeat the last one
+    for (; n < k; ++n)
+      out[n] = out[n - 1];
+  });
+
+  // jet fitting on the kNN neighborhoods
+  std::cout << "Compute differential quantities via jet fitting..." << std::endl;
+  m_k1.assign(nb_points, 0.0);
+  m_k2.assign(nb_points, 0.0);
+  m_d1.assign(nb_points, Vector_3(0, 0, 0));
+  m_d2.assign(nb_points, Vector_3(0, 0, 0));
+  Algs::parallel_for(nb_points, [&](const std::size_t i) {
+    // the fitting is done around the first point
+    std::vector<Point_3> in_points;
+    in_points.reserve(k);
+    in_points.push_back(m_points[i].first);
+    const std::size_t *neighbors = knn.data() + i * k;
+    for (std::size_t n = 0; n < k; ++n)
+      if (neighbors[n] != i)
+        in_points.push_back(m_points[neighbors[n]].first);
+    if (in_points.size() < min_nb_points)
+      return;
+
+    Monge_via_jet_fitting monge_fit;
+    Monge_form monge_form = monge_fit(in_points.begin(), in_points.end(),
+      d_fitting, d_monge);
+    //switch min-max ppal curv/dir wrt the point normal
+    monge_form.comply_wrt_given_normal(m_points[i].second);
+
+    m_k1[i] = monge_form.coefficients()[0];
+    m_k2[i] = monge_form.coefficients()[1];
+    m_d1[i] = monge_form.maximal_principal_direction();
+    m_d2[i] = monge_form.minimal_principal_direction();
+  });
+
+  // sharp features: strong curvature, maximal across the feature
+  // curvature magnitude, its mean and direction
+  std::vector<double> curvature(nb_points, 0.0);
+  double mean_curvature = 0.0;
+  for (std::size_t i = 0; i < nb_points; ++i) {
+    curvature[i] = std::max(std::abs(m_k1[i]), std::abs(m_k2[i]));
+    mean_curvature += curvature[i];
+  }
+  mean_curvature /= double(nb_points);
+  const double sharp_curvature = params.sharpness_ratio * mean_curvature;
+
+  m_is_sharp.assign(nb_points, 0);
+  Algs::parallel_for(nb_points, [&](const std::size_t i) {
+    if (curvature[i] < sharp_curvature || curvature[i] == 0.0)
+      return;
+
+    const Vector_3 &dir = std::abs(m_k1[i]) >= std::abs(m_k2[i]) ? m_d1[i] : m_d2[i];
+    const std::size_t *neighbors = knn.data() + i * k;
+    for (std::size_t n = 0; n < k; ++n) {
+      const std::size_t j = neighbors[n];
+      if (j == i)
+        continue;
+      const Vector_3 offset = m_points[j].first - m_points[i].first;
+      const double len = std::sqrt(offset.squared_length());
+      if (len == 0.0 || std::abs(offset * dir) < sharp_cone_cos * len)
+        continue;
+      if (curvature[j] > curvature[i])
+        return;
+    }
+    m_is_sharp[i] = 1;
+  });
+
+  const std::size_t nb_sharp = std::count(m_is_sharp.begin(), m_is_sharp.end(), 1);
+  std::cout << "#points " << nb_points
+    << "\n#mean curvature " << mean_curvature
+    << "\n#sharp points " << nb_sharp << std::endl;
+
+  // coloring to curvature, saturated at the sharpness level
+  m_point_colors.assign(nb_points, 0);
+  if (sharp_curvature > 0.0)
+    for (std::size_t i = 0; i < nb_points; ++i)
+      m_point_colors[i] = std::size_t(std::min(curvature[i] / sharp_curvature, 1.0) * 255.0);
+
+  build_buffers();
+}
+
+void Point_ridge_detection::build_buffers()
+{
+  const double cx = (m_bbox.xmin() + m_bbox.xmax()) / 2.0;
+  const double cy = (m_bbox.ymin() + m_bbox.ymax()) / 2.0;
+  const double cz = (m_bbox.zmin() + m_bbox.zmax()) / 2.0;
+  m_point_buffer.clear(cx, cy, cz);
+  m_point_buffer.reserve(m_points.size());
+  m_sharp_buffer.clear(cx, cy, cz);
+  for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
+    const std::size_t c = m_point_colors[pidx];
+    const Point_3 &p = m_points[pidx].first;
+    m_point_buffer.add_vertex(p, Color_256::r(c), Color_256::g(c), Color_256::b(c));
+    if (m_is_sharp[pidx])
+      m_sharp_buffer.add_vertex(p, 0, 0, 0);
+  }
+  m_point_octree.build(m_point_buffer);
+}
+
+void Point_ridge_detection::draw(const Point_view &view)
+{
+  if (m_points.empty())
+    return;
+
+  // draw point cloud with respect to curvature
+  ::glDisable(GL_LIGHTING);
+  ::glPointSize(2.0);
+  m_point_octree.draw(m_point_buffer, view);
+
+  // draw sharp feature points
+  ::glPointSize(5.0);
+  m_sharp_buffer.draw(GL_POINTS);
+}
+
+} // Algs
@@ -0,0 +1,70 @@
+#ifndef POINT_RIDGE_DETECTION_H
+#define POINT_RIDGE_DETECTION_H
+
+#include "types.h"
+#include "parameters.h"
+#include "Render_buffer.h"
+#include "Point_octree.h"
+
+namespace Algs {
+
+/************************************************************************/
+/* Curvature and Sharp Features on Point Clouds                         */
+/* Jet fitting on k nearest neighbors, no surface reconstruction        */
+/* https://doc.cgal.org/latest/Jet_fitting_3/index.html                 */
+/************************************************************************/
+class Point_ridge_detection {
+  // Type declarations
+  typedef std::pair<Point_3, Vector_3> Point_with_normal;
+  typedef std::vector<Point_with_normal> Pwn_vector;
+
+public:
+  Point_ridge_detection() {}
+
+  void detect(const std::string &fname, const Params::Point_ridge_detection &params);
+
+  const Bbox_3 &bbox() { return m_bbox; }
+
+  // per point results of the last detection, in the order of the file
+  std::size_t nb_points() const { return m_points.size(); }
+  const Point_3 &point(const std::size_t i) const { return m_points[i].first; }
+  // principal curvatures k1 >= k2 and their directions
+  const std::vector<double> &k1() const { return m_k1; }
+  const std::vector<double> &k2() const { return m_k2; }
+  const std::vector<Vector_3> &d1() const { return m_d1; }
+  const std::vector<Vector_3> &d2() const { return m_d2; }
+  // 1 for sharp feature points
+  const std::vector<char> &is_sharp() const { return m_is_sharp; }
+
+  void draw(const Point_view &view);
+
+private:
+  // colored points and sharp points to the render buffers
+  void build_buffers();
+
+private:
+  Bbox_3 m_bbox;
+
+  // points with normals.
+  Pwn_vector m_points;
+
+  // principal curvatures and directions of each point, k1 >= k2
+  std::vector<double> m_k1;
+  std::vector<double> m_k2;
+  std::vector<Vector_3> m_d1;
+  std::vector<Vector_3> m_d2;
+
+  // sharp feature flag of each point
+  std::vector<char> m_is_sharp;
+
+  // rendering data, curvature color of each point
+  std::vector<std::size_t> m_point_colors;
+  Render_buffer m_point_buffer;
+  // level of detail over the reordered point buffer
+  Point_octree m_point_octree;
+  Render_buffer m_sharp_buffer;
+};
+
+} // namespace Algs
+
+#endif // POINT_RIDGE_DETECTION_H
@@ -0,0 +1,303 @@
+#include "Progressive_mesh.h"
+
+#include <limits>
+#include <algorithm>
+
+// stream header
+const char pm_magic[4] = {'A', 'V', 'P', 'M'};
+const std::uint32_t pm_version = 1;
+
+template <typename T>
+static void write_value(std::ostream &os, const T &t)
+{
+  os.write(reinterpret_cast<const char *>(&t), sizeof(T));
+}
+
+template <typename T>
+static void read_value(std::istream &is, T &t)
+{
+  is.read(reinterpret_cast<char *>(&t), sizeof(T));
+}
+
+static void write_point(std::ostream &os, const Point_3 &p)
+{
+  const double xyz[3] = {p.x(), p.y(), p.z()};
+  os.write(reinterpret_cast<const char *>(xyz), sizeof(xyz));
+}
+
+static Point_3 read_point(std::istream &is)
+{
+  double xyz[3] = {0.0, 0.0, 0.0};
+  is.read(reinterpret_cast<char *>(xyz), sizeof(xyz));
+  return Point_3(xyz[0], xyz[1], xyz[2]);
+}
+
+bool Progressive_mesh::build(
+  const std::vector<Point_3> &points,
+  const std::vector<Triangle> &triangles,
+  const std::vector<Collapse> &collapses)
+{
+  const std::size_t nb_points = points.size();
+  const std::size_t nb_triangles = triangles.size();
+  const std::size_t nb_collapses = collapses.size();
+  const std::size_t alive = nb_collapses;
+  const std::size_t dropped = std::numeric_limits<std::size_t>::max();
+
+  // replay the collapses: corners follow the kept vertices and a face dies
+  // with the collapse of one of its edges
+  std::vector<Triangle> current(triangles);
+  std::vector<std::size_t> death(nb_triangles, alive);
+  std::vector<std::vector<std::uint32_t> > incident(nb_points);
+  for (std::size_t f = 0; f < nb_triangles; ++f) {
+    const Triangle &t = triangles[f];
+    if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) {
+      death[f] = dropped;
+      continue;
+    }
+    for (const std::uint32_t v : t)
+      incident[v].push_back(static_cast<std::uint32_t>(f));
+  }
+
+  std::vector<Point_3> positions(points);
+  std::vector<char> is_removed(nb_points, 0);
+  std::vector<Point_3> removed_positions(nb_collapses);
+  std::vector<Point_3> kept_positions(nb_collapses);
+  // faces dying with collapse k and corners moved by it, in order
+  std::vector<std::vector<std::uint32_t> > dead_faces(nb_collapses);
+  std::vector<std::vector<std::uint32_t> > moved_corners(nb_collapses);
+  for (std::size_t k = 0; k < nb_collapses; ++k) {
+    const std::size_t r = collapses[k].removed;
+    const std::size_t q = collapses[k].kept;
+    if (r >= nb_points || q >= nb_points || r == q || is_removed[r] || is_removed[q]) {
+      std::cerr << "invalid collapse " << k << std::endl;
+      return false;
+    }
+    is_removed[r] = 1;
+    removed_positions[k] = positions[r];
+    kept_positions[k] = positions[q];
+
+    for (const std::uint32_t f : incident[r]) {
+      if (death[f] != alive)
+        continue;
+      Triangle &t = current[f];
+      if (t[0] == q || t[1] == q || t[2] == q) {
+        death[f] = k;
+        dead_faces[k].push_back(f);
+        continue;
+      }
+      for (std::uint32_t c = 0; c < 3; ++c) {
+        if (t[c] == r) {
+          t[c] = static_cast<std::uint32_t>(q);
+          moved_corners[k].push_back(f * 3 + c);
+        }
+      }
+      incident[q].push_back(f);
+    }
+    std::vector<std::uint32_t>().swap(incident[r]);
+    positions[q] = collapses[k].position;
+  }
+  std::vector<std::vector<std::uint32_t> >().swap(incident);
+
+  // base vertices first, then the child of each split, the split undoing
+  // the last collapse first
+  m_nb_base_vertices = nb_points - nb_collapses;
+  std::vector<std::uint32_t> vertex_index(nb_points);
+  std::size_t nb_base = 0;
+  for (std::size_t v = 0; v < nb_points; ++v)
+    if (!is_removed[v])
+      vertex_index[v] = static_cast<std::uint32_t>(nb_base++);
+  for (std::size_t k = 0; k < nb_collapses; ++k)
+    vertex_index[collapses[k].removed] =
+      static_cast<std::uint32_t>(m_nb_base_vertices + nb_collapses - 1 - k);
+
+  // faces alive in the base mesh first, then the faces added by each split
+  std::vector<std::uint32_t> face_order;
+  face_order.reserve(nb_triangles);
+  for (std::size_t f = 0; f < nb_triangles; ++f)
+    if (death[f] == alive)
+      face_order.push_back(static_cast<std::uint32_t>(f));
+  m_nb_base_faces = face_order.size();
+  for (std::size_t k = nb_collapses; k-- > 0;)
+    face_order.insert(face_order.end(), dead_faces[k].begin(), dead_faces[k].end());
+  std::vector<std::uint32_t> face_index(nb_triangles, 0);
+  for (std::size_t i = 0; i < face_order.size(); ++i)
+    face_index[face_order[i]] = static_cast<std::uint32_t>(i);
+
+  // the base mesh, the faces of the splits at the resolution they are added
+  m_points.assign(nb_points, Point_3(0.0, 0.0, 0.0));
+  for (std::size_t v = 0; v < nb_points; ++v)
+    if (!is_removed[v])
+      m_points[vertex_index[v]] = positions[v];
+  m_triangles.resize(face_order.size());
+  for (std::size_t i = 0; i < face_order.size(); ++i)
+    for (std::size_t c = 0; c < 3; ++c)
+      m_triangles[i][c] = vertex_index[current[face_order[i]][c]];
+
+  m_splits.resize(nb_collapses);
+  m_split_offsets.assign(1, 0);
+  m_corners.clear();
+  for (std::size_t j = 0; j < nb_collapses; ++j) {
+    const std::size_t k = nb_collapses - 1 - j;
+    Vertex_split &split = m_splits[j];
+    split.parent = vertex_index[collapses[k].kept];
+    split.coarse_position = collapses[k].position;
+    split.fine_position = kept_positions[k];
+    split.child_position = removed_positions[k];
+    split.nb_faces = static_cast<std::uint32_t>(dead_faces[k].size());
+    for (const std::uint32_t corner : moved_corners[k])
+      m_corners.push_back(face_index[corner / 3] * 3 + corner % 3);
+    m_split_offsets.push_back(m_corners.size());
+  }
+
+  m_level = 0;
+  m_nb_faces = m_nb_base_faces;
+  set_level(nb_collapses);
+
+  return true;
+}
+
+void Progressive_mesh::set_level(const std::size_t level)
+{
+  const std::size_t target = std::min(level, m_splits.size());
+  while (m_level < target)
+    apply_split(m_level++);
+  while (m_level > target)
+    undo_split(--m_level);
+}
+
+void Progressive_mesh::apply_split(const std::size_t j)
+{
+  const Vertex_split &split = m_splits[j];
+  const std::uint32_t child = static_cast<std::uint32_t>(m_nb_base_vertices + j);
+  m_points[split.parent] = split.fine_position;
+  m_points[child] = split.child_position;
+  for (std::size_t i = m_split_offsets[j]; i < m_split_offsets[j + 1]; ++i)
+    m_triangles[m_corners[i] / 3][m_corners[i] % 3] = child;
+  m_nb_faces += split.nb_faces;
+}
+
+void Progressive_mesh::undo_split(const std::size_t j)
+{
+  const Vertex_split &split = m_splits[j];
+  m_points[split.parent] = split.coarse_position;
+  for (std::size_t i = m_split_offsets[j]; i < m_split_offsets[j + 1]; ++i)
+    m_triangles[m_corners[i] / 3][m_corners[i] % 3] = split.parent;
+  m_nb_faces -= split.nb_faces;
+}
+
+bool Progressive_mesh::write(std::ostream &os)
+{
+  // streamed from the base mesh, the current resolution is restored after
+  const std::size_t level = m_level;
+  set_level(0);
+
+  os.write(pm_magic, sizeof(pm_magic));
+  write_value(os, pm_version);
+  write_value(os, std::uint64_t(m_nb_base_vertices));
+  write_value(os, std::uint64_t(m_nb_base_faces));
+  write_value(os, std::uint64_t(m_splits.size()));
+  for (std::size_t v = 0; v < m_nb_base_vertices; ++v)
+    write_point(os, m_points[v]);
+  for (std::size_t f = 0; f < m_nb_base_faces; ++f)
+    os.write(reinterpret_cast<const char *>(m_triangles[f].data()), sizeof(Triangle));
+
+  // each split with its added faces and moved corners
+  std::size_t face = m_nb_base_faces;
+  for (std::size_t j = 0; j < m_splits.size(); ++j) {
+    const Vertex_split &split = m_splits[j];
+    write_value(os, split.parent);
+    write_point(os, split.coarse_position);
+    write_point(os, split.fine_position);
+    write_point(os, split.child_position);
+    write_value(os, split.nb_faces);
+    for (std::size_t i = 0; i < split.nb_faces; ++i, ++face)
+      os.write(reinterpret_cast<const char *>(m_triangles[face].data()), sizeof(Triangle));
+    write_value(os, std::uint32_t(m_split_offsets[j + 1] - m_split_offsets[j]));
+    os.write(reinterpret_cast<const char *>(m_corners.data() + m_split_offsets[j]),
+      (m_split_offsets[j + 1] - m_split_offsets[j]) * sizeof(std::uint32_t));
+  }
+  set_level(level);
+
+  return bool(os);
+}
+
+bool Progressive_mesh::read(std::istream &is)
+{
+  char magic[4] = {0, 0, 0, 0};
+  std::uint32_t version = 0;
+  is.read(magic, sizeof(magic));
+  read_value(is, version);
+  if (!is || !std::equal(magic, magic + 4, pm_magic) || version != pm_version) {
+    std::cerr << "invalid progressive mesh stream" << std::endl;
+    return false;
+  }
+
+  std::uint64_t nb_base_vertices = 0, nb_base_faces = 0, nb_splits = 0;
+  read_value(is, nb_base_vertices);
+  read_value(is, nb_base_faces);
+  read_value(is, nb_splits);
+  if (!is) {
+    std::cerr << "invalid progressive mesh stream" << std::endl;
+    return false;
+  }
+
+  m_nb_base_vertices = std::size_t(nb_base_vertices);
+  m_nb_base_faces = std::size_t(nb_base_faces);
+  m_points.resize(m_nb_base_vertices);
+  for (Point_3 &p : m_points)
+    p = read_point(is);
+  m_triangles.resize(m_nb_base_faces);
+  for (Triangle &t : m_triangles)
+    is.read(reinterpret_cast<char *>(t.data()), sizeof(Triangle));
+
+  m_splits.clear();
+  m_split_offsets.assign(1, 0);
+  m_corners.clear();
+  for (std::uint64_t j = 0; j < nb_splits && is; ++j) {
+    Vertex_split split;
+    read_value(is, split.parent);
+    split.coarse_position = read_point(is);
+    split.fine_position = read_point(is);
+    split.child_position = read_point(is);
+    read_value(is, split.nb_faces);
+    for (std::uint32_t i = 0; i < split.nb_faces && is; ++i) {
+      Triangle t;
+      is.read(reinterpret_cast<char *>(t.data()), sizeof(Triangle));
+      m_triangles.push_back(t);
+    }
+    std::uint32_t nb_corners = 0;
+    read_value(is, nb_corners);
+    const std::size_t offset = m_corners.size();
+    m_corners.resize(offset + nb_corners);
+    is.read(reinterpret_cast<char *>(m_corners.data() + offset), nb_corners * sizeof(std::uint32_t));
+    m_splits.push_back(split);
+    m_split_offsets.push_back(m_corners.size());
+    m_points.push_back(split.child_position);
+  }
+  if (!is) {
+    std::cerr << "truncated progressive mesh stream" << std::endl;
+    return false;
+  }
+
+  // indices must stay within the full resolution
+  for (const Triangle &t : m_triangles)
+    for (const std::uint32_t v : t)
+      if (v >= m_points.size()) {
+        std::cerr << "invalid progressive mesh stream" << std::endl;
+        return false;
+      }
+  for (const Vertex_split &split : m_splits)
+    if (split.parent >= m_points.size()) {
+      std::cerr << "invalid progressive mesh stream" << std::endl;
+      return false;
+    }
+  for (const std::uint32_t corner : m_corners)
+    if (corner / 3 >= m_triangles.size()) {
+      std::cerr << "invalid progressive mesh stream" << std::endl;
+      return false;
+    }
+
+  m_level = 0;
+  m_nb_faces = m_nb_base_faces;
+  return true;
+}
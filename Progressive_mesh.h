@@ -0,0 +1,102 @@
+#ifndef PROGRESSIVE_MESH_H
+#define PROGRESSIVE_MESH_H
+
+#include "types.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+/*!
+ * \brief Progressive mesh built from a sequence of edge collapses.
+ * The mesh is stored as the base mesh left by the collapses followed by
+ * the vertex splits undoing them, last collapse first. Vertices and faces
+ * are ordered so that any resolution is a prefix of both arrays, moving
+ * between resolutions replays the splits in between.
+ */
+class Progressive_mesh {
+public:
+  typedef std::array<std::uint32_t, 3> Triangle;
+
+  /*!
+   * \brief The removed vertex is merged into the kept one, moved to position.
+   */
+  struct Collapse {
+    std::size_t removed;
+    std::size_t kept;
+    Point_3 position;
+  };
+
+  Progressive_mesh() : m_nb_base_vertices(0), m_nb_base_faces(0), m_level(0), m_nb_faces(0) {}
+
+  /*!
+   * \brief Build from a triangle mesh and the collapses applied to it in order,
+   * the mesh is set to the full resolution.
+   * \return false if a collapse does not match the mesh
+   */
+  bool build(const std::vector<Point_3> &points,
+    const std::vector<Triangle> &triangles,
+    const std::vector<Collapse> &collapses);
+
+  // number of vertex splits from the base mesh to the full resolution
+  std::size_t nb_splits() const { return m_splits.size(); }
+
+  // number of vertex splits applied to the base mesh
+  std::size_t level() const { return m_level; }
+
+  /*!
+   * \brief Apply or undo vertex splits until level splits are applied.
+   */
+  void set_level(const std::size_t level);
+
+  // vertices and faces of the current resolution
+  std::size_t nb_vertices() const { return m_nb_base_vertices + m_level; }
+  std::size_t nb_faces() const { return m_nb_faces; }
+  const std::vector<Point_3> &points() const { return m_points; }
+  const std::vector<Triangle> &triangles() const { return m_triangles; }
+
+  /*!
+   * \brief Binary stream, the base mesh first so that a reader can display
+   * it before the vertex splits are received. Moves to the base mesh
+   * to write it and back to the current resolution.
+   */
+  bool write(std::ostream &os);
+  bool read(std::istream &is);
+
+private:
+  struct Vertex_split {
+    std::uint32_t parent;
+    // parent position before and after the split
+    Point_3 coarse_position;
+    Point_3 fine_position;
+    Point_3 child_position;
+    // number of faces added, they follow the active faces
+    std::uint32_t nb_faces;
+    // corners moved from the parent to the child at
+    // [m_split_offsets[j], m_split_offsets[j + 1]) of m_corners
+  };
+
+  void apply_split(const std::size_t j);
+  void undo_split(const std::size_t j);
+
+private:
+  std::size_t m_nb_base_vertices;
+  std::size_t m_nb_base_faces;
+
+  // vertex positions of the current resolution, the child of split j
+  // is vertex m_nb_base_vertices + j
+  std::vector<Point_3> m_points;
+  // faces with the vertices of the current resolution for the active ones
+  std::vector<Triangle> m_triangles;
+
+  std::vector<Vertex_split> m_splits;
+  std::vector<std::size_t> m_split_offsets;
+  // face * 3 + corner
+  std::vector<std::uint32_t> m_corners;
+
+  std::size_t m_level;
+  std::size_t m_nb_faces;
+};
+
+#endif // PROGRESSIVE_MESH_H
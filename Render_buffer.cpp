@@ -0,0 +1,295 @@
+#include "Render_buffer.h"
+
+#include <QOpenGLContext>
+
+#include <limits>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <gl/gl.h>
+
+// address of a vertex attribute from the base of the vertices, null for the bound buffer
+#define VERTEX_ATTRIBUTE(base, member) \
+  reinterpret_cast<const void *>( \
+    reinterpret_cast<std::uintptr_t>(base) + offsetof(Render_buffer::Vertex, member))
+
+// work of all the buffers, drawn from the GUI thread only
+static Render_buffer::Stats submitted;
+
+// primitives drawn from count vertices
+static std::size_t nb_primitives(const unsigned int mode, const std::size_t count)
+{
+  switch (mode) {
+    case GL_LINES: return count / 2;
+    case GL_LINE_STRIP: return count > 0 ? count - 1 : 0;
+    case GL_TRIANGLES: return count / 3;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN: return count > 1 ? count - 2 : 0;
+    default: return count;
+  }
+}
+
+// OpenGL 1.4, not exported by the 1.1 headers on Windows
+typedef void (APIENTRY *Multi_draw_arrays)(
+  GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount);
+
+const Render_buffer::Stats &Render_buffer::stats()
+{
+  return submitted;
+}
+
+void Render_buffer::clear(const double x, const double y, const double z)
+{
+  std::vector<Vertex>().swap(m_vertices);
+  std::vector<std::uint32_t>().swap(m_indices);
+  m_origin[0] = x;
+  m_origin[1] = y;
+  m_origin[2] = z;
+  m_is_dirty = true;
+}
+
+void Render_buffer::add_vertex(
+  const double x, const double y, const double z,
+  const double nx, const double ny, const double nz,
+  const unsigned char r,
+  const unsigned char g,
+  const unsigned char b,
+  const unsigned char a)
+{
+  Vertex v;
+  v.position[0] = float(x - m_origin[0]);
+  v.position[1] = float(y - m_origin[1]);
+  v.position[2] = float(z - m_origin[2]);
+  v.normal[0] = float(nx);
+  v.normal[1] = float(ny);
+  v.normal[2] = float(nz);
+  v.color[0] = r;
+  v.color[1] = g;
+  v.color[2] = b;
+  v.color[3] = a;
+  m_vertices.push_back(v);
+  m_is_dirty = true;
+}
+
+void Render_buffer::add_triangle_fan(const std::size_t first, const std::size_t count)
+{
+  for (std::size_t i = 2; i < count; ++i) {
+    m_indices.push_back(std::uint32_t(first));
+    m_indices.push_back(std::uint32_t(first + i - 1));
+    m_indices.push_back(std::uint32_t(first + i));
+  }
+  m_is_dirty = true;
+}
+
+void Render_buffer::add_line_loop(const std::size_t first, const std::size_t count)
+{
+  if (count < 2)
+    return;
+  for (std::size_t i = 0; i < count; ++i) {
+    m_indices.push_back(std::uint32_t(first + i));
+    m_indices.push_back(std::uint32_t(first + (i + 1) % count));
+  }
+  m_is_dirty = true;
+}
+
+void Render_buffer::shuffle_primitives(const std::size_t nb_indices)
+{
+  if (nb_indices == 0)
+    return;
+  const std::size_t nb = m_indices.size() / nb_indices;
+  std::vector<std::size_t> order(nb);
+  for (std::size_t i = 0; i < nb; ++i)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(0u));
+  std::vector<std::uint32_t> indices;
+  indices.reserve(m_indices.size());
+  for (const std::size_t i : order)
+    indices.insert(indices.end(),
+      m_indices.begin() + i * nb_indices, m_indices.begin() + (i + 1) * nb_indices);
+  m_indices.swap(indices);
+  m_is_dirty = true;
+}
+
+void Render_buffer::reorder(const std::vector<std::uint32_t> &order)
+{
+  std::vector<Vertex> vertices;
+  vertices.reserve(order.size());
+  for (const std::uint32_t i : order)
+    vertices.push_back(m_vertices[i]);
+  m_vertices.swap(vertices);
+  m_is_dirty = true;
+}
+
+void Render_buffer::set_color(
+  const std::size_t i,
+  const unsigned char r,
+  const unsigned char g,
+  const unsigned char b,
+  const unsigned char a)
+{
+  unsigned char *color = m_vertices[i].color;
+  if (color[0] == r && color[1] == g && color[2] == b && color[3] == a)
+    return;
+  color[0] = r;
+  color[1] = g;
+  color[2] = b;
+  color[3] = a;
+  m_is_dirty = true;
+}
+
+void Render_buffer::draw(const unsigned int mode, const bool with_normals)
+{
+  draw(mode, 0, m_indices.empty() ? m_vertices.size() : m_indices.size(), with_normals);
+}
+
+void Render_buffer::draw_prefix(
+  const unsigned int mode,
+  const std::size_t max_primitives,
+  const bool with_normals)
+{
+  const std::size_t count = m_indices.empty() ? m_vertices.size() : m_indices.size();
+  if (max_primitives == 0) {
+    draw(mode, 0, count, with_normals);
+    return;
+  }
+  const std::size_t nb_vertices = mode == GL_TRIANGLES ? 3 : (mode == GL_LINES ? 2 : 1);
+  draw(mode, 0, std::min(count, max_primitives * nb_vertices), with_normals);
+}
+
+void Render_buffer::draw(
+  const unsigned int mode,
+  const std::size_t first,
+  const std::size_t count,
+  const bool with_normals)
+{
+  const bool is_indexed = !m_indices.empty();
+  if (count == 0
+    || first + count > (is_indexed ? m_indices.size() : m_vertices.size())
+    || !upload())
+    return;
+
+  begin_draw(with_normals);
+  if (is_indexed && m_is_client_side)
+    ::glDrawElements(GLenum(mode), GLsizei(count), GL_UNSIGNED_INT, m_indices.data() + first);
+  else if (is_indexed) {
+    m_ibo.bind();
+    ::glDrawElements(GLenum(mode), GLsizei(count), GL_UNSIGNED_INT,
+      reinterpret_cast<const void *>(first * sizeof(std::uint32_t)));
+    m_ibo.release();
+  }
+  else
+    ::glDrawArrays(GLenum(mode), GLint(first), GLsizei(count));
+  end_draw(with_normals);
+
+  ++submitted.nb_draws;
+  submitted.nb_primitives += nb_primitives(mode, count);
+}
+
+void Render_buffer::draw(
+  const unsigned int mode,
+  const std::vector<int> &firsts,
+  const std::vector<int> &counts,
+  const bool with_normals)
+{
+  if (firsts.empty() || firsts.size() != counts.size() || !upload())
+    return;
+
+  begin_draw(with_normals);
+  const QOpenGLContext *context = QOpenGLContext::currentContext();
+  const Multi_draw_arrays multi_draw_arrays = context ? reinterpret_cast<Multi_draw_arrays>(
+    context->getProcAddress("glMultiDrawArrays")) : nullptr;
+  if (multi_draw_arrays)
+    multi_draw_arrays(GLenum(mode), firsts.data(), counts.data(), GLsizei(firsts.size()));
+  else {
+    for (std::size_t i = 0; i < firsts.size(); ++i)
+      ::glDrawArrays(GLenum(mode), firsts[i], counts[i]);
+  }
+  end_draw(with_normals);
+
+  ++submitted.nb_draws;
+  for (const int count : counts)
+    submitted.nb_primitives += nb_primitives(mode, std::size_t(count));
+}
+
+void Render_buffer::begin_draw(const bool with_normals)
+{
+  const char *base = nullptr;
+  if (m_is_client_side)
+    base = reinterpret_cast<const char *>(m_vertices.data());
+  else
+    m_vbo.bind();
+  ::glEnableClientState(GL_VERTEX_ARRAY);
+  ::glVertexPointer(3, GL_FLOAT, sizeof(Vertex), VERTEX_ATTRIBUTE(base, position));
+  if (with_normals) {
+    ::glEnableClientState(GL_NORMAL_ARRAY);
+    ::glNormalPointer(GL_FLOAT, sizeof(Vertex), VERTEX_ATTRIBUTE(base, normal));
+  }
+  ::glEnableClientState(GL_COLOR_ARRAY);
+  ::glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), VERTEX_ATTRIBUTE(base, color));
+
+  ::glPushMatrix();
+  ::glTranslated(m_origin[0], m_origin[1], m_origin[2]);
+}
+
+void Render_buffer::end_draw(const bool with_normals)
+{
+  ::glPopMatrix();
+
+  ::glDisableClientState(GL_COLOR_ARRAY);
+  if (with_normals)
+    ::glDisableClientState(GL_NORMAL_ARRAY);
+  ::glDisableClientState(GL_VERTEX_ARRAY);
+  if (!m_is_client_side)
+    m_vbo.release();
+}
+
+bool Render_buffer::upload()
+{
+  // QOpenGLBuffer sizes are int, larger buffers are drawn from client memory,
+  // as are all buffers of a context not made by Qt, which QOpenGLBuffer needs
+  const std::size_t max_bytes = std::size_t(std::numeric_limits<int>::max());
+  const bool is_too_large = m_vertices.size() > max_bytes / sizeof(Vertex)
+    || m_indices.size() > max_bytes / sizeof(std::uint32_t);
+  if (is_too_large || !QOpenGLContext::currentContext()) {
+    if (is_too_large && !m_is_client_side)
+      std::cerr << "buffer of " << m_vertices.size() << " vertices and "
+        << m_indices.size() << " indices drawn from client memory" << std::endl;
+    m_is_client_side = true;
+    m_is_dirty = false;
+    return true;
+  }
+  m_is_client_side = false;
+
+  if (!m_vbo.isCreated()) {
+    if (!m_vbo.create())
+      return false;
+    m_is_dirty = true;
+  }
+  if (!m_indices.empty() && !m_ibo.isCreated()) {
+    if (!m_ibo.create())
+      return false;
+    m_is_dirty = true;
+  }
+  if (!m_is_dirty)
+    return true;
+
+  m_vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+  m_vbo.bind();
+  m_vbo.allocate(m_vertices.data(), int(m_vertices.size() * sizeof(Vertex)));
+  m_vbo.release();
+  if (!m_indices.empty()) {
+    m_ibo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_ibo.bind();
+    m_ibo.allocate(m_indices.data(), int(m_indices.size() * sizeof(std::uint32_t)));
+    m_ibo.release();
+  }
+  m_is_dirty = false;
+  submitted.upload_bytes += m_vertices.size() * sizeof(Vertex)
+    + m_indices.size() * sizeof(std::uint32_t);
+
+  return true;
+}
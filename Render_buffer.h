@@ -0,0 +1,181 @@
+#ifndef RENDER_BUFFER_H
+#define RENDER_BUFFER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <QOpenGLBuffer>
+
+/*!
+ * \brief Interleaved float vertices drawn from a vertex buffer object with
+ * one call. The vertices are filled out of any GL context, when an algorithm
+ * finishes, and uploaded at the next draw, again only if they changed.
+ * Positions are stored relative to an origin so that large coordinates keep
+ * their precision in float. With indices the primitives are indexed.
+ * Buffers too large for a buffer object are drawn from client memory.
+ */
+class Render_buffer {
+public:
+  struct Vertex {
+    float position[3];
+    float normal[3];
+    unsigned char color[4];
+  };
+
+  /*!
+   * \brief Work submitted by all the buffers, cumulated, parts are measured
+   * by the difference before and after their draw.
+   */
+  struct Stats {
+    Stats() : nb_draws(0), nb_primitives(0), upload_bytes(0) {}
+    std::size_t nb_draws;
+    std::size_t nb_primitives;
+    std::size_t upload_bytes;
+  };
+
+  static const Stats &stats();
+
+  Render_buffer() : m_ibo(QOpenGLBuffer::IndexBuffer), m_is_dirty(false), m_is_client_side(false) {
+    m_origin[0] = m_origin[1] = m_origin[2] = 0.0;
+  }
+
+  /*!
+   * \brief Remove the vertices and indices, the positions added next are
+   * relative to (x, y, z).
+   */
+  void clear(const double x = 0.0, const double y = 0.0, const double z = 0.0);
+
+  void reserve(const std::size_t nb_vertices, const std::size_t nb_indices = 0) {
+    m_vertices.reserve(nb_vertices);
+    m_indices.reserve(nb_indices);
+  }
+
+  std::size_t size() const { return m_vertices.size(); }
+
+  bool empty() const { return m_vertices.empty(); }
+
+  std::size_t nb_indices() const { return m_indices.size(); }
+
+  const Vertex &vertex(const std::size_t i) const { return m_vertices[i]; }
+
+  // positions are relative to the origin
+  const double *origin() const { return m_origin; }
+
+  /*!
+   * \brief Move the old vertex order[i] to i, for unindexed buffers.
+   */
+  void reorder(const std::vector<std::uint32_t> &order);
+
+  void add_index(const std::uint32_t i) {
+    m_indices.push_back(i);
+    m_is_dirty = true;
+  }
+
+  /*!
+   * \brief Index the convex polygon of count vertices from first as a fan of
+   * GL_TRIANGLES.
+   */
+  void add_triangle_fan(const std::size_t first, const std::size_t count);
+
+  /*!
+   * \brief Index the closed polyline of count vertices from first as GL_LINES.
+   */
+  void add_line_loop(const std::size_t first, const std::size_t count);
+
+  /*!
+   * \brief Shuffle the primitives of nb_indices indices of an indexed buffer,
+   * so that any prefix of them is spread over the whole buffer.
+   */
+  void shuffle_primitives(const std::size_t nb_indices);
+
+  template <typename Point>
+  void add_vertex(const Point &p,
+    const unsigned char r,
+    const unsigned char g,
+    const unsigned char b,
+    const unsigned char a = 255) {
+    add_vertex(p.x(), p.y(), p.z(), 0.0, 0.0, 1.0, r, g, b, a);
+  }
+
+  template <typename Point, typename Vector>
+  void add_vertex(const Point &p,
+    const Vector &n,
+    const unsigned char r,
+    const unsigned char g,
+    const unsigned char b,
+    const unsigned char a = 255) {
+    add_vertex(p.x(), p.y(), p.z(), n.x(), n.y(), n.z(), r, g, b, a);
+  }
+
+  void add_vertex(const double x, const double y, const double z,
+    const double nx, const double ny, const double nz,
+    const unsigned char r,
+    const unsigned char g,
+    const unsigned char b,
+    const unsigned char a);
+
+  /*!
+   * \brief Recolor a vertex, the buffer is uploaded again at the next draw.
+   */
+  void set_color(const std::size_t i,
+    const unsigned char r,
+    const unsigned char g,
+    const unsigned char b,
+    const unsigned char a = 255);
+
+  /*!
+   * \brief Draw the vertices as primitives of the GL mode, with the current
+   * lighting state, the normals are only sent if with_normals.
+   */
+  void draw(const unsigned int mode, const bool with_normals = false);
+
+  /*!
+   * \brief Draw the first max_primitives primitives of the GL_POINTS, GL_LINES
+   * or GL_TRIANGLES mode, all of them if 0.
+   */
+  void draw_prefix(const unsigned int mode,
+    const std::size_t max_primitives,
+    const bool with_normals = false);
+
+  /*!
+   * \brief Draw count vertices from first, or count indices if indexed.
+   */
+  void draw(const unsigned int mode,
+    const std::size_t first,
+    const std::size_t count,
+    const bool with_normals = false);
+
+  /*!
+   * \brief Draw the runs of counts[i] vertices from firsts[i] with one
+   * glMultiDrawArrays if available, for separate strips sharing the buffer.
+   * The indices are ignored.
+   */
+  void draw(const unsigned int mode,
+    const std::vector<int> &firsts,
+    const std::vector<int> &counts,
+    const bool with_normals = false);
+
+private:
+  // create and fill the vertex buffer object if needed in the current Qt context,
+  // or fall back to the client arrays without one or if the buffers are too large
+  bool upload();
+
+  // bind the buffer and point the client arrays to it, translated to the origin
+  void begin_draw(const bool with_normals);
+  void end_draw(const bool with_normals);
+
+private:
+  std::vector<Vertex> m_vertices;
+  std::vector<std::uint32_t> m_indices;
+  double m_origin[3];
+
+  // released with the context if not current at destruction
+  QOpenGLBuffer m_vbo;
+  QOpenGLBuffer m_ibo;
+  bool m_is_dirty;
+  // drawn from m_vertices and m_indices, without buffer objects
+  bool m_is_client_side;
+};
+
+#endif // RENDER_BUFFER_H
@@ -5,15 +5,28 @@
 ////////////////////////////////////////////////////
 
 #include "Ridge_detection.h"
-#include "PolyhedralSurf_rings.h"
+#include "Ring_neighborhoods.h"
+#include "Mesh_patches.h"
+#include "Umbilic_estimator.h"
+#include "Object_pool.h"
+#include "Memory_usage.h"
+
+#include "Parallel.h"
 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <limits>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
 
 #include <CGAL/Kernel/global_functions.h>
 #include <CGAL/Monge_via_jet_fitting.h>
 #include <CGAL/Ridges.h>
-#include <CGAL/Umbilics.h>
 
 // filtering
 #include <CGAL/linear_least_squares_fitting_3.h>
@@ -25,12 +38,10 @@
 #include "Color_256.h"
 
 // property maps
-typedef boost::property_map<Surface_mesh, boost::vertex_point_t>::type VertexPoint_property_map;
 typedef Surface_mesh::Property_map<vertex_descriptor, FT> VertexFT_property_map;
 typedef Surface_mesh::Property_map<vertex_descriptor, Vector_3> VertexVector_property_map;
 typedef Surface_mesh::Property_map<face_descriptor, Vector_3> FaceVector_property_map;
 
-typedef T_PolyhedralSurf_rings<Surface_mesh> Poly_rings;
 typedef CGAL::Monge_via_jet_fitting<Kernel> Monge_via_jet_fitting;
 typedef Monge_via_jet_fitting::Monge_form Monge_form;
 
@@ -41,199 +52,398 @@ typedef CGAL::Ridge_approximation<
   VertexFT_property_map,
   VertexVector_property_map> Ridge_approximation;
 
-// UMBILICS
-typedef CGAL::Umbilic<Surface_mesh> Umbilic;
-typedef CGAL::Umbilic_approximation<
-  Surface_mesh,
-  VertexFT_property_map,
-  VertexVector_property_map> Umbilic_approximation;
-
 // default fct parameter values and global variables
 unsigned int d_fitting = 3;
 unsigned int d_monge = 3;
-unsigned int nb_rings = 0;//seek min # of rings to get the required #pts
-unsigned int nb_points_to_use = 0;//
 CGAL::Ridge_order tag_order = CGAL::Ridge_order_3;
-double umb_size = 2;
-bool verbose = false;
 unsigned int min_nb_points = (d_fitting + 1) * (d_fitting + 2) / 2;
 
-// property maps
-VertexPoint_property_map vpm;
-FaceVector_property_map fvm;
-VertexFT_property_map vertex_k1_pm, vertex_k2_pm,
-  vertex_b0_pm, vertex_b3_pm,
-  vertex_P1_pm, vertex_P2_pm;
-VertexVector_property_map vertex_d1_pm, vertex_d2_pm;
+// memory report across repeated detections
+std::size_t nb_detection_runs = 0;
+std::size_t first_run_memory = 0;
+
+/*!
+ * \brief Differential quantities of one fitting scale, needed by ridges and umbilics.
+ */
+struct Differential_maps {
+  VertexFT_property_map k1, k2, b0, b3, P1, P2;
+  VertexVector_property_map d1, d2;
+};
+
+/*!
+ * \brief Add the property maps of one fitting scale to the mesh.
+ */
+Differential_maps add_differential_maps(Surface_mesh &mesh, const std::size_t scale);
+
+/*!
+ * \brief Remove the property maps of one fitting scale from the mesh.
+ */
+void remove_differential_maps(Surface_mesh &mesh, Differential_maps &dm);
+
+/*!
+ * \brief Remove the property maps of the fittings, the mesh may be shared.
+ */
+void remove_fitting_maps(Surface_mesh &mesh,
+  FaceVector_property_map &fvm,
+  std::vector<Differential_maps> &scales);
 
 /*!
  * \brief Compute face normal.
  */
-void compute_facets_normal(const Surface_mesh &P);
+void compute_facets_normal(const Surface_mesh &mesh, FaceVector_property_map &fvm);
 
-Vector_3 compute_facets_average_unit_normal(const Surface_mesh& tm, vertex_descriptor v);
+Vector_3 compute_facets_average_unit_normal(
+  const Surface_mesh &mesh,
+  const FaceVector_property_map &fvm,
+  vertex_descriptor v);
 
 /*!
- * \brief Gather points around the vertex v using rings on the polyhedralsurf.
+ * \brief Build the ring neighborhoods once, large enough for all the scales.
+ */
+void build_fitting_neighborhoods(
+  const Surface_mesh &mesh,
+  const Params::Ridge_detection &params,
+  Ring_neighborhoods &neighborhoods);
+
+/*!
+ * \brief Gather points around the vertex v using rings on the mesh.
  * The collection of points resorts to 3 alternatives:
  * 1. the exact number of points to be used
  * 2. the exact number of rings to be used
  * 3. nothing is specified
+ * Scale k adds k rings, or k times the number of points, to the first scale.
  */
 void gather_fitting_points(
+  const Surface_mesh &mesh,
   vertex_descriptor v,
-  std::vector<Point_3> &in_points,
-  Poly_rings &poly_rings);
+  const std::size_t scale,
+  const Params::Ridge_detection &params,
+  const Ring_neighborhoods &neighborhoods,
+  std::vector<Point_3> &in_points);
+
+/*!
+ * \brief Use the jet_fitting package to compute differential quantities,
+ * all the scales are fitted in one pass over the vertices.
+ * Vertices not flagged in is_required (all of them if null) with too few
+ * points get a flat fitting and are counted in nb_unfitted.
+ * \return false if there are too few points to perform the fitting
+ * on a required vertex.
+ */
+bool compute_differential_quantities(
+  const Surface_mesh &mesh,
+  const FaceVector_property_map &fvm,
+  const Params::Ridge_detection &params,
+  const Ring_neighborhoods &neighborhoods,
+  const std::vector<char> *is_required,
+  std::vector<Differential_maps> &scales,
+  std::size_t &nb_unfitted);
+
+/*!
+ * \brief Post-processing outcome of one ridge line.
+ */
+struct Ridge_candidate {
+  // filtering status, the first failed test
+  enum Status { KEPT, WEAK, SHORT, SCATTERED, STEEP };
+
+  Ridge_candidate() :
+    status(KEPT), is_max(false), strength(0.0), length(0.0), quality(0.0), angle(0.0) {}
+
+  Status status;
+  bool is_max;
+  double strength;
+  double length;
+  double quality;
+  // |z| of the fitted line direction
+  double angle;
+
+  // interpolated ridge points and fitted line, valid if kept
+  std::vector<Point_3> points;
+  Segment_3 fit_line;
+};
+
+/*!
+ * \brief Aggregated statistics of the ridge filtering, replaces per ridge output.
+ */
+struct Ridge_filter_stats {
+  Ridge_filter_stats() :
+    nb_ridges(0), nb_weak(0), nb_short(0), nb_scattered(0), nb_steep(0),
+    nb_max_crest(0), nb_min_crest(0),
+    sum_length(0.0), sum_quality(0.0), sum_strength(0.0),
+    min_length(std::numeric_limits<double>::max()), max_length(0.0) {}
+
+  void add(const Ridge_candidate &c);
+
+  void print(std::ostream &os) const;
+
+  std::size_t nb_ridges;
+  std::size_t nb_weak;
+  std::size_t nb_short;
+  std::size_t nb_scattered;
+  std::size_t nb_steep;
+  // kept ridges
+  std::size_t nb_max_crest;
+  std::size_t nb_min_crest;
+  double sum_length;
+  double sum_quality;
+  double sum_strength;
+  double min_length;
+  double max_length;
+};
+
+/*!
+ * \brief Interpolate the ridge line points and run the strength, length,
+ * straightness and angle tests. Only reads the mesh, safe to run concurrently.
+ */
+void filter_ridge(const Ridge_line &rl, const Surface_mesh &mesh, Ridge_candidate &c);
+
+/*!
+ * \brief Run the length, straightness and angle tests on the candidate points,
+ * the strength test on the candidate strength.
+ */
+void filter_ridge_points(Ridge_candidate &c);
+
+/*!
+ * \brief Fit all the scales on the mesh, trace the crest ridges of each scale
+ * and measure the umbilic estimator of the first one. Ridge lines of scale s
+ * are in the pool at [scale_ranges[s], scale_ranges[s + 1]).
+ * Only the vertices flagged in is_required (all of them if null) must be fitted.
+ * \return false if there are too few points to perform the fitting.
+ */
+bool approximate_ridges_and_umbilics(
+  Surface_mesh &mesh,
+  const Params::Ridge_detection &params,
+  const bool verbose,
+  const std::vector<char> *is_required,
+  Object_pool<Ridge_line> &ridge_pool,
+  std::vector<std::size_t> &scale_ranges,
+  Umbilic_estimator &umbilic_estimator,
+  std::size_t &nb_unfitted);
+
+// mesh edge as its (min, max) vertex indices
+typedef std::pair<std::size_t, std::size_t> Edge_key;
+
+/*!
+ * \brief Piece of ridge line crossing one core face of a patch,
+ * its ends are identified by the crossed edges of the whole mesh.
+ */
+struct Ridge_segment {
+  Edge_key edges[2];
+  Point_3 points[2];
+  double strength;
+  bool is_max;
+};
+
+/*!
+ * \brief Results of one patch, everything else is released with the patch.
+ */
+struct Patch_ridges {
+  Patch_ridges() :
+    is_failed(false), nb_failed_faces(0), nb_unfitted(0), nb_pooled(0), pool_bytes(0) {}
+
+  // ridge segments on the core faces, per scale
+  std::vector<std::vector<Ridge_segment>> segments;
+  // umbilics on the owned vertices
+  std::vector<Point_3> umbilics;
+  bool is_failed;
+  std::size_t nb_failed_faces;
+  // halo vertices with too few points for the fitting
+  std::size_t nb_unfitted;
+  std::size_t nb_pooled;
+  std::size_t pool_bytes;
+};
 
 /*!
- * \brief Use the jet_fitting package and the class Poly_rings to compute differential quantities.
+ * \brief Vertex rings around the core faces of a patch so that the fitting
+ * and umbilic neighborhoods of the core vertices are complete.
+ * With a number of points, rings are estimated on a regular triangulation.
  */
-void compute_differential_quantities(Surface_mesh &P, Poly_rings &poly_rings);
+std::size_t patch_halo_rings(const Params::Ridge_detection &params);
+
+/*!
+ * \brief Cut the ridge line to the segments crossing core faces of the patch,
+ * the line strength is shared among segments by length.
+ */
+void extract_core_segments(
+  const Ridge_line &rl,
+  const Mesh_patches::Patch &patch,
+  std::vector<Ridge_segment> &segments);
+
+/*!
+ * \brief Stitch ridge segments of the same type sharing a crossed edge into
+ * ridge candidates, in segment order.
+ */
+void stitch_ridge_segments(
+  const std::vector<Ridge_segment> &segments,
+  std::vector<Ridge_candidate> &candidates);
 
 namespace Algs {
 
-void Ridge_detection::detect(const std::string &fname)
+void Ridge_detection::detect(Surface_mesh &mesh, const Params::Ridge_detection &params)
 {
-  // load triangle mesh
-  std::ifstream ifs(fname);
-  if (!ifs.is_open()) {
-    std::cerr << "Error: failed to open " << fname << std::endl;
-    return;
-  }
-  m_mesh = Surface_mesh();
-  ifs >> m_mesh;
-  ifs.close();
-
-  if (min_nb_points > num_vertices(m_mesh)) {
+  m_mesh = nullptr;
+  if (min_nb_points > num_vertices(mesh)) {
     std::cerr << "not enough points in the model" << std::endl;
     return;
   }
 
-  std::cout << "#v " << num_vertices(m_mesh) 
-    << "\n#e " << num_edges(m_mesh)
-    << "\n#f " << num_faces(m_mesh) << std::endl;
+  // vertex indices are used to address per vertex data
+  if (mesh.has_garbage())
+    mesh.collect_garbage();
 
-  //initialize the property maps
-  vpm = get(CGAL::vertex_point, m_mesh);
-  fvm = m_mesh.add_property_map<face_descriptor, Vector_3>("f:n", Vector_3(0, 0, 0)).first;
-  //initialize Polyhedral data : normal of facets
-  compute_facets_normal(m_mesh);
+  std::cout << "#v " << num_vertices(mesh) 
+    << "\n#e " << num_edges(mesh)
+    << "\n#f " << num_faces(mesh) << std::endl;
 
-  m_bbox = get(vpm, *vertices(m_mesh).first).bbox();
-  BOOST_FOREACH(const vertex_descriptor v, vertices(m_mesh))
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  m_bbox = get(vpm, *vertices(mesh).first).bbox();
+  BOOST_FOREACH(const vertex_descriptor v, vertices(mesh))
     m_bbox += get(vpm, v).bbox();
 
-  vertex_k1_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:k1", 0).first;
-  vertex_k2_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:k2", 0).first;
-  vertex_b0_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:b0", 0).first;
-  vertex_b3_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:b3", 0).first;
-  vertex_P1_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:P1", 0).first;
-  vertex_P2_pm = m_mesh.add_property_map<vertex_descriptor, FT>("v:P2", 0).first;
-  vertex_d1_pm = m_mesh.add_property_map<vertex_descriptor, Vector_3>("v:d1", Vector_3(0, 0, 0)).first;
-  vertex_d2_pm = m_mesh.add_property_map<vertex_descriptor, Vector_3>("v:d2", Vector_3(0, 0, 0)).first;
+  // ridge candidates of each scale, filtered
+  const std::size_t nb_scales = std::max(params.nb_scales, 1u);
+  std::vector<std::vector<Ridge_candidate>> candidates(nb_scales);
+  m_umbilics.clear();
+  m_umbilic_estimator.clear();
+  std::size_t pool_bytes = 0;
+  std::size_t nb_pooled = 0;
+  if (params.patch_size != 0 && num_faces(mesh) > params.patch_size) {
+    // large mesh, per vertex data only lives in the patches being processed
+    Mesh_patches patches;
+    patches.build(mesh, params.patch_size);
+    const std::size_t halo_rings = patch_halo_rings(params);
+    std::cout << "Compute ridges in " << patches.size() << " patches, "
+      << halo_rings << " halo rings, " << nb_scales << " scale(s)..." << std::endl;
 
-  //create a Poly_rings object
-  Poly_rings poly_rings(m_mesh);
+    // patches are processed concurrently, each one releases its data when done
+    std::vector<Patch_ridges> results(patches.size());
+    Algs::parallel_for(patches.size(), [&](const std::size_t i) {
+      Mesh_patches::Patch patch;
+      patches.extract(mesh, i, halo_rings, patch);
 
-  //compute differential quantities with the jet fitting package
-  std::cout << "Compute differential quantities via jet fitting..." << std::endl;
-  compute_differential_quantities(m_mesh, poly_rings);
+      Patch_ridges &r = results[i];
+      r.nb_failed_faces = patch.failed_faces.size();
+      Object_pool<Ridge_line> ridge_pool;
+      Umbilic_estimator umbilic_estimator;
+      std::vector<std::size_t> scale_ranges;
+      // the outer halo vertices may lack points, only the core ones need a fitting
+      std::vector<char> is_required(patch.is_owned_vertex);
+      BOOST_FOREACH(const face_descriptor f, faces(patch.mesh))
+        if (patch.is_core_face[std::size_t(f)])
+          BOOST_FOREACH(const vertex_descriptor v,
+            vertices_around_face(halfedge(f, patch.mesh), patch.mesh))
+            is_required[std::size_t(v)] = 1;
+      if (!approximate_ridges_and_umbilics(patch.mesh, params, false, &is_required,
+        ridge_pool, scale_ranges, umbilic_estimator, r.nb_unfitted)) {
+        r.is_failed = true;
+        return;
+      }
 
-  //Ridges
-  //--------------------------------------------------------------------------
-  std::cout << "Compute ridges..." << std::endl;
-  Ridge_approximation ridge_approximation(m_mesh,
-    vertex_k1_pm, vertex_k2_pm,
-    vertex_b0_pm, vertex_b3_pm,
-    vertex_d1_pm, vertex_d2_pm,
-    vertex_P1_pm, vertex_P2_pm);
-
-  std::vector<Ridge_line *> ridge_lines;
-  //Find MAX_RIDGE, MIN_RIDGE, CREST or all ridges
-  // ridge_approximation.compute_max_ridges(std::back_inserter(ridge_lines), tag_order);
-  // ridge_approximation.compute_min_ridges(std::back_inserter(ridge_lines), tag_order);
-  ridge_approximation.compute_crest_ridges(std::back_inserter(ridge_lines), tag_order);
-
-  // or with the global function
-  // CGAL::compute_max_ridges(m_mesh,
-  //   vertex_k1_pm, vertex_k2_pm,
-  //   vertex_b0_pm, vertex_b3_pm,
-  //   vertex_d1_pm, vertex_d2_pm,
-  //   vertex_P1_pm, vertex_P2_pm,
-  //   std::back_inserter(ridge_lines), tag_order);
-
-  // to rendering data
-  m_ridges.clear();
-  m_fit_lines.clear();
-  std::vector<double> ridge_strength;
-  std::vector<double> ridge_angle;
-  std::cout << "#ridges " << ridge_lines.size() << std::endl;
-  for (const auto &rl : ridge_lines) {
-    // strength filtering
-    if (rl->strength() < 1.0)
-      continue;
+      r.segments.resize(nb_scales);
+      for (std::size_t s = 0; s < nb_scales; ++s)
+        for (std::size_t j = scale_ranges[s]; j < scale_ranges[s + 1]; ++j)
+          extract_core_segments(*ridge_pool[j], patch, r.segments[s]);
+
+      std::vector<vertex_descriptor> umbilics;
+      umbilic_estimator.classify(patch.mesh, params.umb_size, umbilics);
+      const auto patch_vpm = get(CGAL::vertex_point, patch.mesh);
+      for (const vertex_descriptor v : umbilics)
+        if (patch.is_owned_vertex[std::size_t(v)])
+          r.umbilics.push_back(get(patch_vpm, v));
+
+      r.pool_bytes = ridge_pool.bytes();
+      r.nb_pooled = ridge_pool.size();
+    });
 
-    std::vector<Point_3> ridge;
-    for (const auto &rhe : *(rl->line())) {
-      // linear interpolation of ridge point
-      const Vector_3 p = get(vpm, source(rhe.first, m_mesh)) - CGAL::ORIGIN;
-      const Vector_3 q = get(vpm, target(rhe.first, m_mesh)) - CGAL::ORIGIN;
-      const Point_3 pt = CGAL::ORIGIN + (p * rhe.second + (1.0 - rhe.second) * q);
-      ridge.push_back(pt);
+    // stitch the ridges across the patch borders
+    std::size_t nb_failed_patches = 0;
+    std::size_t nb_failed_faces = 0;
+    std::size_t nb_unfitted = 0;
+    std::vector<std::vector<Ridge_segment>> segments(nb_scales);
+    for (auto &r : results) {
+      nb_failed_faces += r.nb_failed_faces;
+      nb_unfitted += r.nb_unfitted;
+      if (r.is_failed) {
+        ++nb_failed_patches;
+        continue;
+      }
+      for (std::size_t s = 0; s < nb_scales; ++s)
+        segments[s].insert(segments[s].end(), r.segments[s].begin(), r.segments[s].end());
+      m_umbilics.insert(m_umbilics.end(), r.umbilics.begin(), r.umbilics.end());
+      pool_bytes += r.pool_bytes;
+      nb_pooled += r.nb_pooled;
     }
+    if (nb_failed_patches != 0)
+      std::cerr << "Too few points to perform the fitting in "
+        << nb_failed_patches << " patches" << std::endl;
+    if (nb_failed_faces != 0)
+      std::cerr << nb_failed_faces << " non-manifold halo faces dropped" << std::endl;
+    if (nb_unfitted != 0)
+      std::cout << "#unfitted_halo_vertices " << nb_unfitted << std::endl;
 
-    // filtering
-    assert(ridge.size() >= 2);
-    // test length
-    double len = 0.0;
-    Kernel::Point_3 pre = ridge.front();
-    for (const auto p : ridge) {
-      len += std::sqrt(CGAL::squared_distance(pre, p));
-      pre = p;
+    for (std::size_t s = 0; s < nb_scales; ++s) {
+      std::cout << "#segments scale " << s << " " << segments[s].size() << std::endl;
+      stitch_ridge_segments(segments[s], candidates[s]);
+      std::vector<Ridge_segment>().swap(segments[s]);
+      std::vector<Ridge_candidate> &cs = candidates[s];
+      Algs::parallel_for(cs.size(), [&](const std::size_t i) {
+        filter_ridge_points(cs[i]);
+      });
     }
-    if (len < 2.0)
-      continue;
-    // test straightness
-    Kernel::Line_3 line;
-    Kernel::Point_3 centroid;
-
-    // fitting to segments leads to wrong results, don't know why
-    // std::vector<Kernel::Segment_3> segments;
-    // for (std::size_t i = 1; i < ridge.size(); ++i)
-    //   segments.push_back({ridge[i - 1], ridge[i]});
-    // const double quality = CGAL::linear_least_squares_fitting_3(
-    //   segments.begin(), segments.end(),
-    //   line, centroid, CGAL::Dimension_tag<1>());
-
-    const double quality = CGAL::linear_least_squares_fitting_3(
-      ridge.begin(), ridge.end(),
-      line, centroid, CGAL::Dimension_tag<0>());
-    std::cout << "#len " << len << std::endl;
-    std::cout << "#quality " << quality << std::endl;
-    if (quality < 0.5)
-      continue;
+  }
+  else {
+    // results of the CGAL approximators, owned by this run
+    Object_pool<Ridge_line> ridge_pool;
+    std::vector<std::size_t> scale_ranges;
+    std::size_t nb_unfitted = 0;
+    if (!approximate_ridges_and_umbilics(mesh, params, true, nullptr,
+      ridge_pool, scale_ranges, m_umbilic_estimator, nb_unfitted))
+      return;
 
-    // test angle
-    Kernel::Vector_3 v = line.to_vector();
-    v /= std::sqrt(v.squared_length());
-    // std::cout << "#v " << v << std::endl;
-    // std::cout << "#angle " << std::abs(v.z()) << std::endl;
-    if (std::abs(v.z()) > 0.5)
-      continue;
-    ridge_angle.push_back(std::abs(v.z()));
+    // filter ridge lines in parallel, each one writes its own slot
+    for (std::size_t s = 0; s < nb_scales; ++s) {
+      std::vector<Ridge_candidate> &cs = candidates[s];
+      cs.resize(scale_ranges[s + 1] - scale_ranges[s]);
+      Algs::parallel_for(cs.size(), [&](const std::size_t i) {
+        filter_ridge(*ridge_pool[scale_ranges[s] + i], mesh, cs[i]);
+      });
+    }
 
-    m_ridges.push_back(ridge);
+    // the estimator is kept to update the umbilics with another size
+    std::vector<vertex_descriptor> umbilics;
+    m_umbilic_estimator.classify(mesh, params.umb_size, umbilics);
+    for (const vertex_descriptor v : umbilics)
+      m_umbilics.push_back(get(vpm, v));
 
-    m_fit_lines.push_back({centroid + v * len / 2.0, centroid - v * len / 2.0});
+    // release all approximation results in one shot
+    pool_bytes = ridge_pool.bytes();
+    nb_pooled = ridge_pool.size();
+    ridge_pool.clear();
+  }
+  m_mesh = &mesh;
+  m_params = params;
 
-    // std::cout << ridge_length << std::endl;
-    std::cout <<
-      (rl->line_type() == CGAL::Ridge_type::MAX_CREST_RIDGE ? "MAX_CREST" : "MIN_CREST") << " "
-      << rl->strength() << " " << rl->sharpness() << std::endl;
-    ridge_strength.push_back(rl->strength());
+  // to rendering data, in ridge line order
+  m_scales.assign(nb_scales, Ridge_set());
+  for (std::size_t s = 0; s < nb_scales; ++s) {
+    std::cout << "Ridges at scale " << s << std::endl;
+    Ridge_set &rs = m_scales[s];
+    Ridge_filter_stats stats;
+    for (auto &c : candidates[s]) {
+      stats.add(c);
+      if (c.status != Ridge_candidate::KEPT)
+        continue;
 
-    delete rl;
+      rs.ridges.push_back(std::move(c.points));
+      rs.fit_lines.push_back(c.fit_line);
+      // coloring to angle, or to scale for comparison
+      if (nb_scales == 1)
+        rs.ridges_color.push_back(std::size_t(c.angle * 255.0));
+      else
+        rs.ridges_color.push_back(s * 255 / (nb_scales - 1));
+    }
+    stats.print(std::cout);
   }
+  build_buffers();
 
   // coloring to strength value
   // std::for_each(ridge_strength.begin(), ridge_strength.end(),
@@ -249,37 +459,101 @@ void Ridge_detection::detect(const std::string &fname)
   // for (const auto &mc : ridge_strength)
   //   m_ridges_color.push_back(std::size_t(
   //     (mc - min_mean_curvature) / (max_mean_curvature - min_mean_curvature) * 255.0));
-  // for (std::size_t i = 0; i < m_ridges_color.size(); ++i)
-  //   std::cout << ridge_strength[i] << ' ' << m_ridges_color[i] << std::endl;
 
-  // coloring to angle
-  m_ridges_color.clear();
-  for (const auto &a : ridge_angle)
-    m_ridges_color.push_back(std::size_t(a * 255.0));
-  for (std::size_t i = 0; i < m_ridges_color.size(); ++i)
-    std::cout << ridge_angle[i] << ' ' << m_ridges_color[i] << std::endl;
+  std::cout << "#umbilics " << m_umbilics.size() << std::endl;
+  if (!m_umbilic_estimator.empty())
+    std::cout << "#umbilic cache " << to_mb(m_umbilic_estimator.bytes()) << " MB" << std::endl;
 
-  // UMBILICS
-  //--------------------------------------------------------------------------
-  std::cout << "Compute umbilics..." << std::endl;
-  Umbilic_approximation umbilic_approximation(m_mesh,
-    vertex_k1_pm, vertex_k2_pm,
-    vertex_d1_pm, vertex_d2_pm);
-  std::vector<Umbilic *> umbilics;
-  std::back_insert_iterator<std::vector<Umbilic *> > umb_it(umbilics);
-  umbilic_approximation.compute(umb_it, umb_size);
-
-  // to rendering data
-  std::cout << "#umbilics " << umbilics.size() << std::endl;
+  // memory report, should stay steady across repeated runs
+  const std::size_t memory = current_memory_usage();
+  if (nb_detection_runs == 0)
+    first_run_memory = memory;
+  ++nb_detection_runs;
+  std::cout << "#memory run " << nb_detection_runs
+    << ", released " << nb_pooled << " objects (" << to_mb(pool_bytes) << " MB)"
+    << ", resident " << to_mb(memory) << " MB"
+    << " (first run " << to_mb(first_run_memory) << " MB)" << std::endl;
+}
+
+bool Ridge_detection::is_same_fitting(
+  const Surface_mesh &mesh,
+  const Params::Ridge_detection &params) const
+{
+  return !m_umbilic_estimator.empty()
+    && &mesh == m_mesh
+    && params.nb_rings == m_params.nb_rings
+    && params.nb_points_to_use == m_params.nb_points_to_use
+    && params.nb_scales == m_params.nb_scales
+    && params.patch_size == m_params.patch_size;
+}
+
+void Ridge_detection::update_umbilics(const double umb_size)
+{
+  if (m_umbilic_estimator.empty() || !m_mesh)
+    return;
+
+  std::vector<vertex_descriptor> umbilics;
+  m_umbilic_estimator.classify(*m_mesh, umb_size, umbilics);
+  const auto vpm = get(CGAL::vertex_point, *m_mesh);
   m_umbilics.clear();
-  for (const auto &u : umbilics) {
-    m_umbilics.push_back(get(vpm, u->vertex()));
+  for (const vertex_descriptor v : umbilics)
+    m_umbilics.push_back(get(vpm, v));
+  m_params.umb_size = umb_size;
+  build_umbilic_buffer();
+  std::cout << "#umbilics " << m_umbilics.size() << std::endl;
+}
 
-    delete u;
+void Ridge_detection::build_buffers()
+{
+  const double cx = (m_bbox.xmin() + m_bbox.xmax()) / 2.0;
+  const double cy = (m_bbox.ymin() + m_bbox.ymax()) / 2.0;
+  const double cz = (m_bbox.zmin() + m_bbox.zmax()) / 2.0;
+  for (Ridge_set &rs : m_scales) {
+    std::size_t nb_points = 0;
+    for (const auto &ridge : rs.ridges)
+      nb_points += ridge.size();
+
+    rs.ridge_buffer.clear(cx, cy, cz);
+    rs.ridge_buffer.reserve(nb_points);
+    rs.ridge_firsts.clear();
+    rs.ridge_counts.clear();
+    rs.fit_line_buffer.clear(cx, cy, cz);
+    rs.fit_line_buffer.reserve(2 * rs.fit_lines.size());
+    // shuffled so that any prefix of the ridges is spread over the mesh
+    std::vector<std::size_t> order(rs.ridges.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(0u));
+    for (const std::size_t i : order) {
+      const std::size_t c = rs.ridges_color[i];
+      const unsigned char r = Color_256::r(c);
+      const unsigned char g = Color_256::g(c);
+      const unsigned char b = Color_256::b(c);
+
+      rs.ridge_firsts.push_back(int(rs.ridge_buffer.size()));
+      rs.ridge_counts.push_back(int(rs.ridges[i].size()));
+      for (const auto &p : rs.ridges[i])
+        rs.ridge_buffer.add_vertex(p, r, g, b);
+
+      rs.fit_line_buffer.add_vertex(rs.fit_lines[i].source(), r, g, b);
+      rs.fit_line_buffer.add_vertex(rs.fit_lines[i].target(), r, g, b);
+    }
   }
+  build_umbilic_buffer();
+}
+
+void Ridge_detection::build_umbilic_buffer()
+{
+  m_umbilic_buffer.clear(
+    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+  m_umbilic_buffer.reserve(m_umbilics.size());
+  for (const auto &p : m_umbilics)
+    m_umbilic_buffer.add_vertex(p, 0, 255, 0);
 }
 
-void Ridge_detection::draw()
+void Ridge_detection::draw(const std::size_t max_segments)
 {
   // ::glEnable(GL_LIGHTING);
   // ::glColor3ub(192, 192, 192);
@@ -299,52 +573,421 @@ void Ridge_detection::draw()
   // ::glEnd();
 
   ::glDisable(GL_LIGHTING);
-  ::glLineWidth(5.0);
-  for (std::size_t i = 0; i < m_ridges.size(); ++i) {
-    const std::size_t c = m_ridges_color[i];
-    ::glColor3ub(Color_256::r(c), Color_256::g(c), Color_256::b(c));
-    ::glBegin(GL_LINE_STRIP);
-    for (const auto &p : m_ridges[i])
-      ::glVertex3d(p.x(), p.y(), p.z());
-    ::glEnd();
-  }
+  for (std::size_t s = 0; s < m_scales.size(); ++s) {
+    Ridge_set &rs = m_scales[s];
+    // coarser scales are thinner
+    ::glLineWidth(5.0f / float(s + 1));
+    if (max_segments == 0) {
+      rs.ridge_buffer.draw(GL_LINE_STRIP, rs.ridge_firsts, rs.ridge_counts);
+      rs.fit_line_buffer.draw(GL_LINES);
+      continue;
+    }
 
-  ::glBegin(GL_LINES);
-  for (std::size_t i = 0; i < m_ridges.size(); ++i) {
-    const std::size_t c = m_ridges_color[i];
-    ::glColor3ub(Color_256::r(c), Color_256::g(c), Color_256::b(c));
-    auto p = m_fit_lines[i].source();
-    ::glVertex3d(p.x(), p.y(), p.z());
-    p = m_fit_lines[i].target();
-    ::glVertex3d(p.x(), p.y(), p.z());
+    // the first ridges within the budget, with their fit lines
+    std::size_t nb_ridges = 0;
+    for (std::size_t nb_segments = 0;
+      nb_ridges < rs.ridge_counts.size() && nb_segments < max_segments; ++nb_ridges)
+      nb_segments += std::size_t(std::max(rs.ridge_counts[nb_ridges] - 1, 0));
+    rs.ridge_buffer.draw(GL_LINE_STRIP,
+      std::vector<int>(rs.ridge_firsts.begin(), rs.ridge_firsts.begin() + nb_ridges),
+      std::vector<int>(rs.ridge_counts.begin(), rs.ridge_counts.begin() + nb_ridges));
+    rs.fit_line_buffer.draw_prefix(GL_LINES, nb_ridges);
   }
-  ::glEnd();
 
   ::glDisable(GL_LIGHTING);
-  ::glColor3ub(0, 255, 0);
   ::glPointSize(5.0);
-  ::glBegin(GL_POINTS);
-  for (const auto &p : m_umbilics)
-    ::glVertex3d(p.x(), p.y(), p.z());
-  ::glEnd();
+  m_umbilic_buffer.draw(GL_POINTS);
 }
 
 } // Algs
 
-void compute_facets_normal(const Surface_mesh &P) {
-  BOOST_FOREACH(face_descriptor f, faces(P)) {
-    halfedge_descriptor h = halfedge(f, P);
-    const Point_3 &p0 = get(vpm, source(h, P));
-    const Point_3 &p1 = get(vpm, target(h, P));
-    const Point_3 &p2 = get(vpm, target(next(h, P), P));
+void Ridge_filter_stats::add(const Ridge_candidate &c)
+{
+  ++nb_ridges;
+  switch (c.status) {
+    case Ridge_candidate::WEAK: ++nb_weak; return;
+    case Ridge_candidate::SHORT: ++nb_short; return;
+    case Ridge_candidate::SCATTERED: ++nb_scattered; return;
+    case Ridge_candidate::STEEP: ++nb_steep; return;
+    default: break;
+  }
+
+  if (c.is_max)
+    ++nb_max_crest;
+  else
+    ++nb_min_crest;
+  sum_length += c.length;
+  sum_quality += c.quality;
+  sum_strength += c.strength;
+  min_length = std::min(min_length, c.length);
+  max_length = std::max(max_length, c.length);
+}
+
+void Ridge_filter_stats::print(std::ostream &os) const
+{
+  const std::size_t nb_kept = nb_max_crest + nb_min_crest;
+  os << "#ridges " << nb_ridges << ", kept " << nb_kept
+    << " (MAX_CREST " << nb_max_crest << ", MIN_CREST " << nb_min_crest << ")"
+    << "\n#rejected strength " << nb_weak
+    << ", length " << nb_short
+    << ", quality " << nb_scattered
+    << ", angle " << nb_steep << std::endl;
+  if (nb_kept == 0)
+    return;
+  os << "#len min " << min_length << ", max " << max_length
+    << ", mean " << sum_length / nb_kept
+    << "\n#quality mean " << sum_quality / nb_kept
+    << "\n#strength mean " << sum_strength / nb_kept << std::endl;
+}
+
+void filter_ridge(const Ridge_line &rl, const Surface_mesh &mesh, Ridge_candidate &c)
+{
+  c.strength = rl.strength();
+  c.is_max = rl.line_type() == CGAL::Ridge_type::MAX_CREST_RIDGE;
+
+  // strength filtering, before the interpolation
+  if (rl.strength() < 1.0) {
+    c.status = Ridge_candidate::WEAK;
+    return;
+  }
+
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  for (const auto &rhe : *(rl.line())) {
+    // linear interpolation of ridge point
+    const Vector_3 p = get(vpm, source(rhe.first, mesh)) - CGAL::ORIGIN;
+    const Vector_3 q = get(vpm, target(rhe.first, mesh)) - CGAL::ORIGIN;
+    c.points.push_back(CGAL::ORIGIN + (p * rhe.second + (1.0 - rhe.second) * q));
+  }
+
+  filter_ridge_points(c);
+}
+
+void filter_ridge_points(Ridge_candidate &c)
+{
+  // strength filtering
+  if (c.strength < 1.0) {
+    c.status = Ridge_candidate::WEAK;
+    return;
+  }
+
+  // filtering
+  const std::vector<Point_3> &ridge = c.points;
+  assert(ridge.size() >= 2);
+  // test length
+  double len = 0.0;
+  Kernel::Point_3 pre = ridge.front();
+  for (const auto &p : ridge) {
+    len += std::sqrt(CGAL::squared_distance(pre, p));
+    pre = p;
+  }
+  c.length = len;
+  if (len < 2.0) {
+    c.status = Ridge_candidate::SHORT;
+    return;
+  }
+
+  // test straightness
+  Kernel::Line_3 line;
+  Kernel::Point_3 centroid;
+
+  // fitting to segments leads to wrong results, don't know why
+  // std::vector<Kernel::Segment_3> segments;
+  // for (std::size_t i = 1; i < ridge.size(); ++i)
+  //   segments.push_back({ridge[i - 1], ridge[i]});
+  // const double quality = CGAL::linear_least_squares_fitting_3(
+  //   segments.begin(), segments.end(),
+  //   line, centroid, CGAL::Dimension_tag<1>());
+
+  c.quality = CGAL::linear_least_squares_fitting_3(
+    ridge.begin(), ridge.end(),
+    line, centroid, CGAL::Dimension_tag<0>());
+  if (c.quality < 0.5) {
+    c.status = Ridge_candidate::SCATTERED;
+    return;
+  }
+
+  // test angle
+  Kernel::Vector_3 v = line.to_vector();
+  v /= std::sqrt(v.squared_length());
+  c.angle = std::abs(v.z());
+  if (c.angle > 0.5) {
+    c.status = Ridge_candidate::STEEP;
+    return;
+  }
+
+  c.fit_line = Segment_3(centroid + v * len / 2.0, centroid - v * len / 2.0);
+  c.status = Ridge_candidate::KEPT;
+}
+
+bool approximate_ridges_and_umbilics(
+  Surface_mesh &mesh,
+  const Params::Ridge_detection &params,
+  const bool verbose,
+  const std::vector<char> *is_required,
+  Object_pool<Ridge_line> &ridge_pool,
+  std::vector<std::size_t> &scale_ranges,
+  Umbilic_estimator &umbilic_estimator,
+  std::size_t &nb_unfitted)
+{
+  //initialize the property maps
+  FaceVector_property_map fvm =
+    mesh.add_property_map<face_descriptor, Vector_3>("f:n", Vector_3(0, 0, 0)).first;
+  //initialize Polyhedral data : normal of facets
+  compute_facets_normal(mesh, fvm);
+
+  // one set of differential quantities per scale
+  const std::size_t nb_scales = std::max(params.nb_scales, 1u);
+  std::vector<Differential_maps> scales;
+  for (std::size_t s = 0; s < nb_scales; ++s)
+    scales.push_back(add_differential_maps(mesh, s));
+
+  // ring neighborhoods of the largest scale, smaller scales are prefixes
+  Ring_neighborhoods neighborhoods;
+  build_fitting_neighborhoods(mesh, params, neighborhoods);
+  if (verbose)
+    std::cout << "#neighborhoods " << to_mb(neighborhoods.bytes()) << " MB" << std::endl;
+
+  //compute differential quantities with the jet fitting package
+  if (verbose)
+    std::cout << "Compute differential quantities via jet fitting at "
+      << nb_scales << " scale(s)..." << std::endl;
+  if (!compute_differential_quantities(mesh, fvm, params, neighborhoods,
+    is_required, scales, nb_unfitted)) {
+    remove_fitting_maps(mesh, fvm, scales);
+    return false;
+  }
+
+  //Ridges
+  //--------------------------------------------------------------------------
+  scale_ranges.assign(1, ridge_pool.size());
+  for (std::size_t s = 0; s < nb_scales; ++s) {
+    if (verbose)
+      std::cout << "Compute ridges at scale " << s << "..." << std::endl;
+    const Differential_maps &dm = scales[s];
+    Ridge_approximation ridge_approximation(mesh,
+      dm.k1, dm.k2,
+      dm.b0, dm.b3,
+      dm.d1, dm.d2,
+      dm.P1, dm.P2);
+
+    //Find MAX_RIDGE, MIN_RIDGE, CREST or all ridges
+    // ridge_approximation.compute_max_ridges(ridge_pool.inserter(), tag_order);
+    // ridge_approximation.compute_min_ridges(ridge_pool.inserter(), tag_order);
+    ridge_approximation.compute_crest_ridges(ridge_pool.inserter(), tag_order);
+    scale_ranges.push_back(ridge_pool.size());
+
+    // or with the global function
+    // CGAL::compute_max_ridges(mesh,
+    //   dm.k1, dm.k2,
+    //   dm.b0, dm.b3,
+    //   dm.d1, dm.d2,
+    //   dm.P1, dm.P2,
+    //   ridge_pool.inserter(), tag_order);
+  }
+
+  // UMBILICS
+  //--------------------------------------------------------------------------
+  // the umbilic size only matters at classification, measured on the fitting neighborhoods
+  if (verbose)
+    std::cout << "Compute umbilic estimator..." << std::endl;
+  const Differential_maps &dm = scales.front();
+  std::vector<double> estimator(mesh.number_of_vertices(), 0.0);
+  std::vector<Vector_3> d1(mesh.number_of_vertices());
+  std::vector<Vector_3> d2(mesh.number_of_vertices());
+  BOOST_FOREACH(const vertex_descriptor v, vertices(mesh)) {
+    estimator[std::size_t(v)] = std::abs(dm.k1[v] - dm.k2[v]);
+    d1[std::size_t(v)] = dm.d1[v];
+    d2[std::size_t(v)] = dm.d2[v];
+  }
+  umbilic_estimator.build(mesh, estimator, d1, d2, neighborhoods);
+
+  // only the ridge lines and the umbilic estimator outlive the fittings
+  remove_fitting_maps(mesh, fvm, scales);
+
+  return true;
+}
+
+std::size_t patch_halo_rings(const Params::Ridge_detection &params)
+{
+  const std::size_t nb_scales = std::max(params.nb_scales, 1u);
+  std::size_t fitting_rings = 0;
+  if (params.nb_points_to_use == 0 && params.nb_rings != 0)
+    fitting_rings = params.nb_rings + nb_scales - 1;
+  else {
+    const std::size_t nb_points = params.nb_points_to_use != 0 ?
+      std::size_t(params.nb_points_to_use) * nb_scales : std::size_t(min_nb_points);
+    // rings 0 to r of a regular triangulation hold 1 + 3r(r + 1) vertices,
+    // one more ring for irregular meshes
+    while (1 + 3 * fitting_rings * (fitting_rings + 1) < nb_points)
+      ++fitting_rings;
+    ++fitting_rings;
+    if (params.nb_points_to_use == 0)
+      fitting_rings += nb_scales - 1;
+  }
+
+  // the umbilic patch of a core vertex needs complete fittings too
+  return fitting_rings + std::size_t(std::ceil(params.umb_size));
+}
+
+void extract_core_segments(
+  const Ridge_line &rl,
+  const Mesh_patches::Patch &patch,
+  std::vector<Ridge_segment> &segments)
+{
+  const Surface_mesh &mesh = patch.mesh;
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  const auto &line = *(rl.line());
+  if (line.size() < 2)
+    return;
+
+  // crossing points and crossed edges of the whole mesh
+  std::vector<Point_3> points;
+  std::vector<Edge_key> edges;
+  std::vector<halfedge_descriptor> halfedges;
+  double len = 0.0;
+  for (const auto &rhe : line) {
+    const vertex_descriptor vs = source(rhe.first, mesh);
+    const vertex_descriptor vt = target(rhe.first, mesh);
+    const Vector_3 p = get(vpm, vs) - CGAL::ORIGIN;
+    const Vector_3 q = get(vpm, vt) - CGAL::ORIGIN;
+    points.push_back(CGAL::ORIGIN + (p * rhe.second + (1.0 - rhe.second) * q));
+    const std::size_t a = std::size_t(patch.to_mesh[std::size_t(vs)]);
+    const std::size_t b = std::size_t(patch.to_mesh[std::size_t(vt)]);
+    edges.push_back(Edge_key(std::min(a, b), std::max(a, b)));
+    halfedges.push_back(rhe.first);
+    if (points.size() > 1)
+      len += std::sqrt(CGAL::squared_distance(points[points.size() - 2], points.back()));
+  }
+
+  const bool is_max = rl.line_type() == CGAL::Ridge_type::MAX_CREST_RIDGE;
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    // the face crossed between two consecutive edges
+    const halfedge_descriptor h0 = halfedges[i - 1];
+    const halfedge_descriptor h1 = halfedges[i];
+    face_descriptor f = face(h0, mesh);
+    if (f == boost::graph_traits<Surface_mesh>::null_face()
+      || (f != face(h1, mesh) && f != face(opposite(h1, mesh), mesh)))
+      f = face(opposite(h0, mesh), mesh);
+    if (f == boost::graph_traits<Surface_mesh>::null_face()
+      || !patch.is_core_face[std::size_t(f)])
+      continue;
+
+    Ridge_segment seg;
+    seg.edges[0] = edges[i - 1];
+    seg.edges[1] = edges[i];
+    seg.points[0] = points[i - 1];
+    seg.points[1] = points[i];
+    seg.strength = len > 0.0 ?
+      rl.strength() * std::sqrt(CGAL::squared_distance(points[i - 1], points[i])) / len : 0.0;
+    seg.is_max = is_max;
+    segments.push_back(seg);
+  }
+}
+
+void stitch_ridge_segments(
+  const std::vector<Ridge_segment> &segments,
+  std::vector<Ridge_candidate> &candidates)
+{
+  // segment ends at each crossed edge, ridge types are stitched apart
+  typedef std::pair<Edge_key, bool> Node;
+  std::unordered_map<Node, std::vector<std::size_t>, boost::hash<Node>> node_ends;
+  for (std::size_t i = 0; i < segments.size(); ++i)
+    for (std::size_t e = 0; e < 2; ++e)
+      node_ends[Node(segments[i].edges[e], segments[i].is_max)].push_back(i * 2 + e);
+
+  // walk from end e of segment i along unused segments
+  std::vector<char> is_used(segments.size(), 0);
+  auto walk = [&](std::size_t i, std::size_t e, Ridge_candidate &c,
+    std::vector<Point_3> &points) {
+    while (true) {
+      // end ids are i * 2 + e, the first one of an unused segment follows
+      const auto &ends = node_ends[Node(segments[i].edges[e], segments[i].is_max)];
+      auto next = std::find_if(ends.begin(), ends.end(),
+        [&](const std::size_t end) { return !is_used[end / 2]; });
+      if (next == ends.end())
+        return;
+      i = *next / 2;
+      e = 1 - *next % 2;
+      is_used[i] = 1;
+      points.push_back(segments[i].points[e]);
+      c.strength += segments[i].strength;
+    }
+  };
+
+  std::vector<Point_3> forward, backward;
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    if (is_used[i])
+      continue;
+    is_used[i] = 1;
+
+    Ridge_candidate c;
+    c.is_max = segments[i].is_max;
+    c.strength = segments[i].strength;
+    forward.assign(1, segments[i].points[1]);
+    walk(i, 1, c, forward);
+    backward.assign(1, segments[i].points[0]);
+    walk(i, 0, c, backward);
+
+    c.points.assign(backward.rbegin(), backward.rend());
+    c.points.insert(c.points.end(), forward.begin(), forward.end());
+    candidates.push_back(std::move(c));
+  }
+}
+
+Differential_maps add_differential_maps(Surface_mesh &mesh, const std::size_t scale)
+{
+  const std::string suffix = "_" + std::to_string(scale);
+  Differential_maps dm;
+  dm.k1 = mesh.add_property_map<vertex_descriptor, FT>("v:k1" + suffix, 0).first;
+  dm.k2 = mesh.add_property_map<vertex_descriptor, FT>("v:k2" + suffix, 0).first;
+  dm.b0 = mesh.add_property_map<vertex_descriptor, FT>("v:b0" + suffix, 0).first;
+  dm.b3 = mesh.add_property_map<vertex_descriptor, FT>("v:b3" + suffix, 0).first;
+  dm.P1 = mesh.add_property_map<vertex_descriptor, FT>("v:P1" + suffix, 0).first;
+  dm.P2 = mesh.add_property_map<vertex_descriptor, FT>("v:P2" + suffix, 0).first;
+  dm.d1 = mesh.add_property_map<vertex_descriptor, Vector_3>("v:d1" + suffix, Vector_3(0, 0, 0)).first;
+  dm.d2 = mesh.add_property_map<vertex_descriptor, Vector_3>("v:d2" + suffix, Vector_3(0, 0, 0)).first;
+  return dm;
+}
+
+void remove_differential_maps(Surface_mesh &mesh, Differential_maps &dm)
+{
+  mesh.remove_property_map(dm.k1);
+  mesh.remove_property_map(dm.k2);
+  mesh.remove_property_map(dm.b0);
+  mesh.remove_property_map(dm.b3);
+  mesh.remove_property_map(dm.P1);
+  mesh.remove_property_map(dm.P2);
+  mesh.remove_property_map(dm.d1);
+  mesh.remove_property_map(dm.d2);
+}
+
+void remove_fitting_maps(Surface_mesh &mesh,
+  FaceVector_property_map &fvm,
+  std::vector<Differential_maps> &scales)
+{
+  for (Differential_maps &dm : scales)
+    remove_differential_maps(mesh, dm);
+  mesh.remove_property_map(fvm);
+}
+
+void compute_facets_normal(const Surface_mesh &mesh, FaceVector_property_map &fvm) {
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  BOOST_FOREACH(face_descriptor f, faces(mesh)) {
+    halfedge_descriptor h = halfedge(f, mesh);
+    const Point_3 &p0 = get(vpm, source(h, mesh));
+    const Point_3 &p1 = get(vpm, target(h, mesh));
+    const Point_3 &p2 = get(vpm, target(next(h, mesh), mesh));
     put(fvm, f, CGAL::unit_normal(p0, p1, p2));
   }
 }
 
-Vector_3 compute_facets_average_unit_normal(const Surface_mesh& tm, vertex_descriptor v)
+Vector_3 compute_facets_average_unit_normal(
+  const Surface_mesh &mesh,
+  const FaceVector_property_map &fvm,
+  vertex_descriptor v)
 {
   Vector_3 sum(0.0, 0.0, 0.0);
-  BOOST_FOREACH(face_descriptor f, faces_around_target(halfedge(v, tm), tm)) {
+  BOOST_FOREACH(face_descriptor f, faces_around_target(halfedge(v, mesh), mesh)) {
     if (f != boost::graph_traits<Surface_mesh>::null_face())
       sum = sum + get(fvm, f);
   }
@@ -353,92 +996,139 @@ Vector_3 compute_facets_average_unit_normal(const Surface_mesh& tm, vertex_descr
   return sum;
 }
 
+void build_fitting_neighborhoods(
+  const Surface_mesh &mesh,
+  const Params::Ridge_detection &params,
+  Ring_neighborhoods &neighborhoods)
+{
+  const std::size_t nb_scales = std::max(params.nb_scales, 1u);
+  if (params.nb_points_to_use != 0)
+    // enough rings for the exact number of points of the largest scale
+    neighborhoods.build(mesh, 0, params.nb_points_to_use * nb_scales, 0);
+  else if (params.nb_rings != 0)
+    // the rings of the largest scale
+    neighborhoods.build(mesh, params.nb_rings + nb_scales - 1, 0, 0);
+  else
+    // enough rings for the fitting, plus one ring per additional scale
+    neighborhoods.build(mesh, 0, min_nb_points, nb_scales - 1);
+}
+
 void gather_fitting_points(
+  const Surface_mesh &mesh,
   vertex_descriptor v,
-  std::vector<Point_3> &in_points,
-  Poly_rings &poly_rings)
+  const std::size_t scale,
+  const Params::Ridge_detection &params,
+  const Ring_neighborhoods &neighborhoods,
+  std::vector<Point_3> &in_points)
 {
-  //container to collect vertices of v on the Surface_mesh
-  std::vector<vertex_descriptor> gathered;
   //initialize
   in_points.clear();
 
-  //OPTION -p nb_points_to_use, with nb_points_to_use != 0. Collect
+  const std::size_t nb_rings = neighborhoods.nb_rings(v);
+  std::size_t nb_gathered = 0;
+  //OPTION -p nb_points_to_use, with nb_points_to_use != 0. Take
   //enough rings and discard some points of the last collected ring to
   //get the exact "nb_points_to_use"
-  if (nb_points_to_use != 0) {
-    poly_rings.collect_enough_rings(v, nb_points_to_use, gathered);
-    if (gathered.size() > nb_points_to_use)
-      gathered.resize(nb_points_to_use);
+  if (params.nb_points_to_use != 0) {
+    nb_gathered = std::min(
+      std::size_t(params.nb_points_to_use) * (scale + 1),
+      neighborhoods.size(v, nb_rings));
   }
   else { // nb_points_to_use=0, this is the default and the option -p is not considered;
-    // then option -a nb_rings is checked. If nb_rings=0, collect
+    // then option -a nb_rings is checked. If nb_rings=0, take
     // enough rings to get the min_nb_points required for the fitting
-    // else collect the nb_rings required
-    if (nb_rings == 0)
-      poly_rings.collect_enough_rings(v, min_nb_points, gathered);
-    else
-      poly_rings.collect_i_rings(v, nb_rings, gathered);
+    // else take the nb_rings required
+    const std::size_t first_ring = params.nb_rings == 0 ?
+      neighborhoods.ring_with(v, min_nb_points) : params.nb_rings;
+    nb_gathered = neighborhoods.size(v, std::min(first_ring + scale, nb_rings));
   }
 
-  //store the gathered points
-  for (const auto &v : gathered)
-    in_points.push_back(get(vpm, v));
+  //store the gathered points, the neighborhood of a scale is a prefix of the next one
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  const vertex_descriptor *gathered = neighborhoods.neighbors(v);
+  for (std::size_t i = 0; i < nb_gathered; ++i)
+    in_points.push_back(get(vpm, gathered[i]));
 }
 
-void compute_differential_quantities(Surface_mesh &P, Poly_rings &poly_rings)
+bool compute_differential_quantities(
+  const Surface_mesh &mesh,
+  const FaceVector_property_map &fvm,
+  const Params::Ridge_detection &params,
+  const Ring_neighborhoods &neighborhoods,
+  const std::vector<char> *is_required,
+  std::vector<Differential_maps> &scales,
+  std::size_t &nb_unfitted)
 {
   //container for approximation points
   std::vector<Point_3> in_points;
+  nb_unfitted = 0;
+
+  BOOST_FOREACH(const vertex_descriptor v, vertices(mesh)) {
+    //switch min-max ppal curv/dir wrt the mesh orientation
+    const Vector_3 normal_mesh = compute_facets_average_unit_normal(mesh, fvm, v);
 
-  BOOST_FOREACH(const vertex_descriptor v, vertices(P)) {
-    //initialize
-    in_points.clear();
-    Monge_form monge_form;
-    Monge_via_jet_fitting monge_fit;
+    for (std::size_t s = 0; s < scales.size(); ++s) {
+      Monge_form monge_form;
+      Monge_via_jet_fitting monge_fit;
 
-    //gather points around the vertex using rings
-    gather_fitting_points(v, in_points, poly_rings);
+      //gather points around the vertex using rings
+      gather_fitting_points(mesh, v, s, params, neighborhoods, in_points);
 
-    //exit if the nb of points is too small
-    if (in_points.size() < min_nb_points) {
-      std::cerr << "Too few points to perform the fitting" << std::endl;
-      exit(1);
-    }
+      //exit if the nb of points is too small
+      if (in_points.size() < min_nb_points) {
+        if (!is_required || (*is_required)[std::size_t(v)]) {
+          std::cerr << "Too few points to perform the fitting" << std::endl;
+          return false;
+        }
+        // flat fitting in the tangent plane, no ridge crosses its edges
+        const Vector_3 axis = std::abs(normal_mesh.x()) < 0.9 ?
+          Vector_3(1.0, 0.0, 0.0) : Vector_3(0.0, 1.0, 0.0);
+        Vector_3 d1 = CGAL::cross_product(normal_mesh, axis);
+        d1 = d1 / std::sqrt(d1 * d1);
+        Differential_maps &dm = scales[s];
+        dm.d1[v] = d1;
+        dm.d2[v] = CGAL::cross_product(normal_mesh, d1);
+        dm.k1[v] = dm.k2[v] = dm.b0[v] = dm.b3[v] = 0.0;
+        dm.P1[v] = dm.P2[v] = 0.0;
+        if (s == 0)
+          ++nb_unfitted;
+        continue;
+      }
 
-    //For Ridges we need at least 3rd order info
-    assert(d_monge >= 3);
-    // run the main fct : perform the fitting
-    monge_form = monge_fit(in_points.begin(), in_points.end(),
-      d_fitting, d_monge);
+      //For Ridges we need at least 3rd order info
+      assert(d_monge >= 3);
+      // run the main fct : perform the fitting
+      monge_form = monge_fit(in_points.begin(), in_points.end(),
+        d_fitting, d_monge);
 
-    //switch min-max ppal curv/dir wrt the mesh orientation
-    const Vector_3 normal_mesh = compute_facets_average_unit_normal(P, v);
-    monge_form.comply_wrt_given_normal(normal_mesh);
-
-    //Store monge data needed for ridge computations in property maps
-    vertex_d1_pm[v] = monge_form.maximal_principal_direction();
-    vertex_d2_pm[v] = monge_form.minimal_principal_direction();
-    vertex_k1_pm[v] = monge_form.coefficients()[0];
-    vertex_k2_pm[v] = monge_form.coefficients()[1];
-    vertex_b0_pm[v] = monge_form.coefficients()[2];
-    vertex_b3_pm[v] = monge_form.coefficients()[5];
-    if (d_monge >= 4) {
-      //= 3*b1^2+(k1-k2)(c0-3k1^3)
-      vertex_P1_pm[v] =
-        3 * monge_form.coefficients()[3] * monge_form.coefficients()[3]
-        + (monge_form.coefficients()[0] - monge_form.coefficients()[1])
-        * (monge_form.coefficients()[6]
-          -3 * monge_form.coefficients()[0] * monge_form.coefficients()[0]
-          * monge_form.coefficients()[0]);
-      //= 3*b2^2+(k2-k1)(c4-3k2^3)
-      vertex_P2_pm[v] =
-        3 * monge_form.coefficients()[4] * monge_form.coefficients()[4]
-        + (-monge_form.coefficients()[0] + monge_form.coefficients()[1])
-        *(monge_form.coefficients()[10]
-          -3 * monge_form.coefficients()[1] * monge_form.coefficients()[1]
-          * monge_form.coefficients()[1]);
+      monge_form.comply_wrt_given_normal(normal_mesh);
+
+      //Store monge data needed for ridge computations in property maps
+      Differential_maps &dm = scales[s];
+      dm.d1[v] = monge_form.maximal_principal_direction();
+      dm.d2[v] = monge_form.minimal_principal_direction();
+      dm.k1[v] = monge_form.coefficients()[0];
+      dm.k2[v] = monge_form.coefficients()[1];
+      dm.b0[v] = monge_form.coefficients()[2];
+      dm.b3[v] = monge_form.coefficients()[5];
+      if (d_monge >= 4) {
+        //= 3*b1^2+(k1-k2)(c0-3k1^3)
+        dm.P1[v] =
+          3 * monge_form.coefficients()[3] * monge_form.coefficients()[3]
+          + (monge_form.coefficients()[0] - monge_form.coefficients()[1])
+          * (monge_form.coefficients()[6]
+            -3 * monge_form.coefficients()[0] * monge_form.coefficients()[0]
+            * monge_form.coefficients()[0]);
+        //= 3*b2^2+(k2-k1)(c4-3k2^3)
+        dm.P2[v] =
+          3 * monge_form.coefficients()[4] * monge_form.coefficients()[4]
+          + (-monge_form.coefficients()[0] + monge_form.coefficients()[1])
+          *(monge_form.coefficients()[10]
+            -3 * monge_form.coefficients()[1] * monge_form.coefficients()[1]
+            * monge_form.coefficients()[1]);
+      }
     }
   }
-}
 
+  return true;
+}
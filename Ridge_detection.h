@@ -9,6 +9,8 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Umbilic_estimator.h"
+#include "Render_buffer.h"
 
 namespace Algs {
 
@@ -17,26 +19,66 @@ namespace Algs {
 /* https://doc.cgal.org/latest/Ridges_3/index.html                      */
 /************************************************************************/
 class Ridge_detection {
+  // ridges detected at one fitting scale
+  struct Ridge_set {
+    std::vector<std::vector<Point_3>> ridges;
+    std::vector<std::size_t> ridges_color;
+    std::vector<Kernel::Segment_3> fit_lines;
+
+    // all ridge polylines in one buffer, ridge i at firsts[i] with counts[i] points
+    Render_buffer ridge_buffer;
+    std::vector<int> ridge_firsts;
+    std::vector<int> ridge_counts;
+    Render_buffer fit_line_buffer;
+  };
+
 public:
-  Ridge_detection() {}
+  Ridge_detection() : m_mesh(nullptr) {}
+
+  /*!
+   * \brief Detect the ridges and umbilics of the mesh, which must outlive the
+   * detection to update the umbilics. Temporary property maps are removed.
+   */
+  void detect(Surface_mesh &mesh, const Params::Ridge_detection &params);
+
+  /*!
+   * \brief True if the last detection ran on the same mesh with the same fitting,
+   * only the umbilics need an update.
+   */
+  bool is_same_fitting(const Surface_mesh &mesh, const Params::Ridge_detection &params) const;
 
-  void detect(const std::string &fname);
+  /*!
+   * \brief Classify the umbilics again with another size, from the cached estimator.
+   */
+  void update_umbilics(const double umb_size);
 
   const Bbox_3 &bbox() { return m_bbox; }
 
-  void draw();
+  // at most max_segments ridge segments per scale, 0 for no limit
+  void draw(const std::size_t max_segments);
+
+private:
+  // ridges and fit lines of each scale to the render buffers
+  void build_buffers();
+
+  // umbilics to their render buffer, again when they are classified again
+  void build_umbilic_buffer();
 
 private:
   Bbox_3 m_bbox;
 
-  Surface_mesh m_mesh;
+  // last detection input
+  Surface_mesh *m_mesh;
+  Params::Ridge_detection m_params;
+
+  // per vertex umbilic measures of the whole mesh, empty for patches
+  Umbilic_estimator m_umbilic_estimator;
 
-  // rendering data
-  std::vector<std::vector<Point_3>> m_ridges;
-  std::vector<std::size_t> m_ridges_color;
-  std::vector<Kernel::Segment_3> m_fit_lines;
+  // rendering data, one ridge set per fitting scale
+  std::vector<Ridge_set> m_scales;
 
   std::vector<Point_3> m_umbilics;
+  Render_buffer m_umbilic_buffer;
 };
 
 } // namespace Algs
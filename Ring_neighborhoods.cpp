@@ -0,0 +1,100 @@
+#include "Ring_neighborhoods.h"
+
+#include <boost/foreach.hpp>
+#include <CGAL/boost/graph/iterator.h>
+
+void Ring_neighborhoods::build(
+  const Surface_mesh &mesh,
+  const std::size_t min_rings,
+  const std::size_t min_points,
+  const std::size_t extra_rings)
+{
+  const std::size_t nb_vertices = mesh.number_of_vertices();
+  m_ring_offsets.assign(1, 0);
+  m_ring_sizes.clear();
+  m_neighbor_offsets.assign(1, 0);
+  m_neighbors.clear();
+  m_ring_offsets.reserve(nb_vertices + 1);
+  m_neighbor_offsets.reserve(nb_vertices + 1);
+
+  std::vector<std::size_t> marks(nb_vertices, 0);
+  std::vector<vertex_descriptor> neighbors;
+  std::vector<std::size_t> ring_sizes;
+  BOOST_FOREACH(const vertex_descriptor v, vertices(mesh)) {
+    collect(mesh, v, min_rings, min_points, extra_rings, marks, neighbors, ring_sizes);
+
+    m_ring_sizes.insert(m_ring_sizes.end(), ring_sizes.begin(), ring_sizes.end());
+    m_ring_offsets.push_back(m_ring_sizes.size());
+    m_neighbors.insert(m_neighbors.end(), neighbors.begin(), neighbors.end());
+    m_neighbor_offsets.push_back(m_neighbors.size());
+  }
+}
+
+std::size_t Ring_neighborhoods::ring_with(const vertex_descriptor v, const std::size_t n) const
+{
+  const std::size_t nb = nb_rings(v);
+  for (std::size_t i = 0; i < nb; ++i)
+    if (size(v, i) >= n)
+      return i;
+  return nb;
+}
+
+std::size_t Ring_neighborhoods::bytes() const
+{
+  return (m_ring_offsets.capacity() + m_ring_sizes.capacity()
+    + m_neighbor_offsets.capacity()) * sizeof(std::size_t)
+    + m_neighbors.capacity() * sizeof(vertex_descriptor);
+}
+
+void Ring_neighborhoods::collect(
+  const Surface_mesh &mesh,
+  const vertex_descriptor v,
+  const std::size_t min_rings,
+  const std::size_t min_points,
+  const std::size_t extra_rings,
+  std::vector<std::size_t> &marks,
+  std::vector<vertex_descriptor> &neighbors,
+  std::vector<std::size_t> &ring_sizes) const
+{
+  const std::size_t stamp = std::size_t(v) + 1;
+  neighbors.clear();
+  ring_sizes.clear();
+
+  // ring 0 is v itself
+  marks[std::size_t(v)] = stamp;
+  neighbors.push_back(v);
+  ring_sizes.push_back(1);
+
+  bool is_enough = false;
+  std::size_t target_rings = 0;
+  std::size_t ring_begin = 0;
+  while (true) {
+    const std::size_t nb = ring_sizes.size() - 1;
+    if (!is_enough && nb >= min_rings && neighbors.size() >= min_points) {
+      is_enough = true;
+      target_rings = nb + extra_rings;
+    }
+    if (is_enough && nb >= target_rings)
+      break;
+
+    // from the current ring, push non-visited neighbors in the next one
+    const std::size_t ring_end = neighbors.size();
+    for (std::size_t i = ring_begin; i < ring_end; ++i) {
+      const halfedge_descriptor h = halfedge(neighbors[i], mesh);
+      if (h == boost::graph_traits<Surface_mesh>::null_halfedge())
+        continue;
+      BOOST_FOREACH(const vertex_descriptor u, vertices_around_target(h, mesh)) {
+        if (marks[std::size_t(u)] == stamp)
+          continue;
+        marks[std::size_t(u)] = stamp;
+        neighbors.push_back(u);
+      }
+    }
+
+    // connected component exhausted
+    if (neighbors.size() == ring_end)
+      break;
+    ring_begin = ring_end;
+    ring_sizes.push_back(neighbors.size());
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef RING_NEIGHBORHOODS_H
+#define RING_NEIGHBORHOODS_H
+
+#include "types.h"
+
+#include <vector>
+
+/*!
+ * \brief Ring neighborhoods of all the vertices of a Surface_mesh, built once.
+ * The vertices around v are stored ring by ring with v first, so ring k
+ * extends ring k-1 and a smaller neighborhood is a prefix of a larger one.
+ */
+class Ring_neighborhoods {
+public:
+  Ring_neighborhoods() {}
+
+  /*!
+   * \brief Collect rings around every vertex until at least min_rings rings
+   * and min_points vertices are gathered, then extra_rings more rings.
+   * Collection stops early when the connected component is exhausted.
+   */
+  void build(const Surface_mesh &mesh,
+    const std::size_t min_rings,
+    const std::size_t min_points,
+    const std::size_t extra_rings);
+
+  // number of rings collected around v, v itself is ring 0
+  std::size_t nb_rings(const vertex_descriptor v) const {
+    return m_ring_offsets[std::size_t(v) + 1] - m_ring_offsets[std::size_t(v)] - 1;
+  }
+
+  // number of vertices up to ring i included, i <= nb_rings(v)
+  std::size_t size(const vertex_descriptor v, const std::size_t i) const {
+    return m_ring_sizes[m_ring_offsets[std::size_t(v)] + i];
+  }
+
+  // smallest ring holding at least n vertices, nb_rings(v) if none
+  std::size_t ring_with(const vertex_descriptor v, const std::size_t n) const;
+
+  // neighborhood of v, v first, size(v, nb_rings(v)) vertices
+  const vertex_descriptor *neighbors(const vertex_descriptor v) const {
+    return m_neighbors.data() + m_neighbor_offsets[std::size_t(v)];
+  }
+
+  // memory held, in bytes
+  std::size_t bytes() const;
+
+private:
+  // collect the rings of v, marks are stamped with v index + 1
+  void collect(const Surface_mesh &mesh,
+    const vertex_descriptor v,
+    const std::size_t min_rings,
+    const std::size_t min_points,
+    const std::size_t extra_rings,
+    std::vector<std::size_t> &marks,
+    std::vector<vertex_descriptor> &neighbors,
+    std::vector<std::size_t> &ring_sizes) const;
+
+private:
+  // per vertex range in m_ring_sizes, nb vertices + 1 entries
+  std::vector<std::size_t> m_ring_offsets;
+  // cumulative number of vertices at the end of each ring
+  std::vector<std::size_t> m_ring_sizes;
+  // per vertex range in m_neighbors, nb vertices + 1 entries
+  std::vector<std::size_t> m_neighbor_offsets;
+  std::vector<vertex_descriptor> m_neighbors;
+};
+
+#endif // RING_NEIGHBORHOODS_H
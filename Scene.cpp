@@ -1,38 +1,59 @@
 #include "Scene.h"
 #include "Surface_simplification.h"
+#include "Vertex_clustering.h"
+#include "Progressive_mesh.h"
 #include "Shape_detection.h"
 #include "Horizontal_plane_detection.h"
 #include "Unit_normal_detection.h"
 #include "Symmetric_normal_detection.h"
 #include "Ridge_detection.h"
+#include "Point_ridge_detection.h"
 
 #include <iostream>
 #include <fstream>
+#include <random>
+#include <algorithm>
+#include <chrono>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 #include <gl/gl.h>
 
-#include <CGAL/IO/Polyhedron_iostream.h>
+#include <boost/foreach.hpp>
+
+// screen area per face of the selected level of detail, in pixels
+const double lod_pixels_per_face = 4.0;
 
 Scene::Scene() :
-  m_pPolyhedron(nullptr),
+  m_mesh(nullptr),
+  m_lod(0),
+  m_progressive_mesh(nullptr),
+  m_is_progressive_dirty(false),
   m_view_polyhedron(false),
+  m_primitive_budget(0),
+  m_is_timing_draws(false),
   m_surface_simplification(nullptr),
+  m_vertex_clustering(nullptr),
   m_shape_detection(nullptr),
   m_horizontal_plane_detection(nullptr),
   m_unit_normal_detection(nullptr),
   m_symmetric_normal_detection(nullptr),
-  m_ridge_detection(nullptr) {
+  m_ridge_detection(nullptr),
+  m_point_ridge_detection(nullptr) {
 }
 
 Scene::~Scene() {
-  if (m_pPolyhedron)
-    delete m_pPolyhedron;
+  if (m_mesh)
+    delete m_mesh;
+  delete_lods();
+  if (m_progressive_mesh)
+    delete m_progressive_mesh;
 
   if (m_surface_simplification)
     delete m_surface_simplification;
+  if (m_vertex_clustering)
+    delete m_vertex_clustering;
   if (m_shape_detection)
     delete m_shape_detection;
   if (m_horizontal_plane_detection)
@@ -43,6 +64,8 @@ Scene::~Scene() {
     delete m_symmetric_normal_detection;
   if (m_ridge_detection)
     delete m_ridge_detection;
+  if (m_point_ridge_detection)
+    delete m_point_ridge_detection;
 }
 
 int Scene::open(const std::string &fname)
@@ -55,37 +78,132 @@ int Scene::open(const std::string &fname)
     return -1;
   }
 
-  if (m_pPolyhedron != nullptr)
-    delete m_pPolyhedron;
+  if (m_mesh != nullptr)
+    delete m_mesh;
+  m_fname.clear();
+  delete_lods();
+  if (m_progressive_mesh != nullptr)
+    delete m_progressive_mesh;
+  m_progressive_mesh = nullptr;
+  // the ridges refer to the previous mesh
+  if (m_ridge_detection)
+    delete m_ridge_detection;
+  m_ridge_detection = nullptr;
 
-  // allocate new polyhedron
-  m_pPolyhedron = new Polyhedron;
-  ifs >> *m_pPolyhedron;
-  if (!ifs) {
+  // allocate new mesh
+  m_mesh = new Surface_mesh;
+  ifs >> *m_mesh;
+  if (m_mesh->is_empty()) {
     std::cerr << "invalid OFF file" << std::endl;
 
-    delete m_pPolyhedron;
-    m_pPolyhedron = nullptr;
+    delete m_mesh;
+    m_mesh = nullptr;
 
     return -1;
   }
+  m_fname = fname;
 
-  m_bbox = CGAL::bbox_3(m_pPolyhedron->points_begin(), m_pPolyhedron->points_end());
+  std::cout << "#v " << m_mesh->number_of_vertices()
+    << "\n#f " << m_mesh->number_of_faces() << std::endl;
+  update_bbox();
+  build_edge_buffers();
   m_view_polyhedron = true;
 
   return 0;
 }
 
-int Scene::surface_simplification(const std::string &fname)
+Surface_mesh *Scene::load_mesh(const std::string &fname)
+{
+  if (m_mesh == nullptr || fname != m_fname)
+    if (open(fname) < 0)
+      return nullptr;
+
+  return m_mesh;
+}
+
+void Scene::update_bbox()
+{
+  if (!m_mesh || m_mesh->is_empty())
+    return;
+
+  m_bbox = m_mesh->point(*vertices(*m_mesh).first).bbox();
+  BOOST_FOREACH(const vertex_descriptor v, vertices(*m_mesh))
+    m_bbox += m_mesh->point(v).bbox();
+}
+
+int Scene::surface_simplification(
+  const std::string &fname,
+  const Params::Surface_simplification &params,
+  const std::function<void(const std::string &)> &progress)
 {
   delete_all_algorithms();
 
   m_surface_simplification = new Algs::Surface_simplification();
-  m_surface_simplification->simplify(fname);
+  m_surface_simplification->set_progress(progress, true);
+  if (params.memory_budget != 0 || params.cluster_resolution != 0) {
+    // streamed or clustered from the file, the result is loaded from out.off
+    if (m_surface_simplification->simplify(fname, params) != EXIT_SUCCESS
+      || open("out.off") < 0)
+      return -1;
+  }
+  else {
+    // the loaded mesh is simplified in place, as written to out.off
+    Surface_mesh *mesh = load_mesh(fname);
+    if (!mesh)
+      return -1;
+    if (m_surface_simplification->simplify(*mesh, params) != EXIT_SUCCESS) {
+      // the mesh may be partly simplified or cleared, back to the file
+      std::cerr << "simplification failed, reloading " << fname << std::endl;
+      open(fname);
+      return -1;
+    }
+    m_fname = "out.off";
+    update_bbox();
+    m_view_polyhedron = true;
+  }
+
+  // the levels of detail replace the mesh
+  const std::vector<Surface_mesh *> lods = m_surface_simplification->release_lods();
+  if (!lods.empty()) {
+    if (m_mesh != nullptr)
+      delete m_mesh;
+    delete_lods();
+    m_mesh = lods.front();
+    m_fname.clear();
+    m_lods.assign(lods.begin() + 1, lods.end());
+    update_bbox();
+    m_view_polyhedron = true;
+  }
+  build_edge_buffers();
+
+  // the progressive mesh replaces the previous one, at full resolution
+  Progressive_mesh *pm = m_surface_simplification->release_progressive_mesh();
+  if (pm) {
+    if (m_progressive_mesh != nullptr)
+      delete m_progressive_mesh;
+    m_progressive_mesh = pm;
+    m_is_progressive_dirty = true;
+    const std::vector<Point_3> &points = pm->points();
+    if (!points.empty())
+      m_bbox = CGAL::bbox_3(points.begin(), points.begin() + pm->nb_vertices());
+    m_view_polyhedron = false;
+  }
+
+  return 0;
+}
+
+int Scene::vertex_clustering(const std::string &fname, const Params::Vertex_clustering &params)
+{
+  delete_all_algorithms();
+
+  m_vertex_clustering = new Algs::Vertex_clustering();
+  if (m_vertex_clustering->simplify(fname, params) != EXIT_SUCCESS)
+    return -1;
+  m_vertex_clustering->write_off("out_clustered.off");
 
   // update viewing bbox
-  // m_bbox = m_surface_simplification->bbox();
-  // m_view_polyhedron = false;
+  m_bbox = m_vertex_clustering->bbox();
+  m_view_polyhedron = false;
 
   return 0;
 }
@@ -149,12 +267,23 @@ int Scene::symmetric_normal_detection(
   return 0;
 }
 
-int Scene::ridge_detection(const std::string &fname)
+int Scene::ridge_detection(const std::string &fname, const Params::Ridge_detection &params)
 {
+  // same mesh and fitting, only reclassify the umbilics
+  if (m_ridge_detection && m_mesh && fname == m_fname
+    && m_ridge_detection->is_same_fitting(*m_mesh, params)) {
+    m_ridge_detection->update_umbilics(params.umb_size);
+    return 0;
+  }
+
   delete_all_algorithms();
 
+  Surface_mesh *mesh = load_mesh(fname);
+  if (!mesh)
+    return -1;
+
   m_ridge_detection = new Algs::Ridge_detection();
-  m_ridge_detection->detect(fname);
+  m_ridge_detection->detect(*mesh, params);
 
   // update viewing bbox
   m_bbox = m_ridge_detection->bbox();
@@ -163,47 +292,201 @@ int Scene::ridge_detection(const std::string &fname)
   return 0;
 }
 
+int Scene::point_ridge_detection(const std::string &fname, const Params::Point_ridge_detection &params)
+{
+  delete_all_algorithms();
+
+  m_point_ridge_detection = new Algs::Point_ridge_detection();
+  m_point_ridge_detection->detect(fname, params);
+
+  // update viewing bbox
+  m_bbox = m_point_ridge_detection->bbox();
+  m_view_polyhedron = false;
+
+  return 0;
+}
+
 void Scene::draw()
 {
+  m_draw_stats.clear();
+
   if (m_view_polyhedron)
-    render_polyhedron();
+    timed_draw("Mesh", [&]() { render_mesh(); });
+
+  if (m_progressive_mesh)
+    timed_draw("Progressive mesh", [&]() { render_progressive_mesh(); });
 
   // if (m_surface_simplification)
   //   m_surface_simplification->draw();
 
+  if (m_vertex_clustering)
+    timed_draw("Vertex clustering", [&]() { m_vertex_clustering->draw(m_primitive_budget); });
+
   if (m_shape_detection)
-    m_shape_detection->draw();
+    timed_draw("Shape detection", [&]() { m_shape_detection->draw(m_primitive_budget); });
 
   if (m_horizontal_plane_detection)
-    m_horizontal_plane_detection->draw();
+    timed_draw("Horizontal plane detection", [&]() {
+      m_horizontal_plane_detection->draw(m_point_view, m_primitive_budget); });
 
   if (m_unit_normal_detection)
-    m_unit_normal_detection->draw();
+    timed_draw("Unit normal detection", [&]() {
+      m_unit_normal_detection->draw(m_point_view); });
 
   if (m_symmetric_normal_detection)
-    m_symmetric_normal_detection->draw();
+    timed_draw("Symmetric normal detection", [&]() {
+      m_symmetric_normal_detection->draw(m_point_view); });
 
   if (m_ridge_detection)
-    m_ridge_detection->draw();
+    timed_draw("Ridge detection", [&]() { m_ridge_detection->draw(m_primitive_budget); });
+
+  if (m_point_ridge_detection)
+    timed_draw("Point ridge detection", [&]() {
+      m_point_ridge_detection->draw(m_point_view); });
+}
+
+void Scene::timed_draw(const char *name, const std::function<void()> &draw)
+{
+  if (!m_is_timing_draws) {
+    draw();
+    return;
+  }
+
+  // the GPU is flushed so that the time covers the rendering of this part,
+  // immediate mode drawing is not counted in the work
+  ::glFinish();
+  const Render_buffer::Stats before = Render_buffer::stats();
+  const auto start = std::chrono::steady_clock::now();
+  draw();
+  ::glFinish();
+  const Render_buffer::Stats &after = Render_buffer::stats();
+
+  Draw_stats stats;
+  stats.name = name;
+  stats.ms = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  stats.work.nb_draws = after.nb_draws - before.nb_draws;
+  stats.work.nb_primitives = after.nb_primitives - before.nb_primitives;
+  stats.work.upload_bytes = after.upload_bytes - before.upload_bytes;
+  m_draw_stats.push_back(stats);
 }
 
-void Scene::render_polyhedron()
+void Scene::render_mesh()
 {
-  if (!m_pPolyhedron)
+  if (!m_mesh || m_lod >= m_edge_buffers.size())
     return;
 
+  // over the budget, a coarser level or else a random subset of the edges
+  std::size_t level = m_lod;
+  std::size_t nb_indices = m_edge_buffers[level].nb_indices();
+  if (m_primitive_budget != 0) {
+    while (nb_indices > 2 * m_primitive_budget && level + 1 < m_edge_buffers.size())
+      nb_indices = m_edge_buffers[++level].nb_indices();
+    nb_indices = std::min(nb_indices, 2 * m_primitive_budget);
+  }
+
   // draw black edges
   ::glDisable(GL_LIGHTING);
-  ::glColor3ub(0, 0, 0);
   ::glLineWidth(1.0f);
-  ::glBegin(GL_LINES);
-  for (auto he = m_pPolyhedron->edges_begin(); he != m_pPolyhedron->edges_end(); ++he) {
-    const Point_3 &a = he->vertex()->point();
-    const Point_3 &b = he->opposite()->vertex()->point();
-    ::glVertex3d(a.x(), a.y(), a.z());
-    ::glVertex3d(b.x(), b.y(), b.z());
+  m_edge_buffers[level].draw(GL_LINES, 0, nb_indices);
+}
+
+void Scene::build_edge_buffers()
+{
+  m_edge_buffers.clear();
+  if (!m_mesh)
+    return;
+
+  // relative to the bbox center, vertices shared by the edges through indices
+  m_edge_buffers.resize(m_lods.size() + 1);
+  for (std::size_t level = 0; level < m_edge_buffers.size(); ++level) {
+    const Surface_mesh &mesh = level == 0 ? *m_mesh : *m_lods[level - 1];
+    Render_buffer &buffer = m_edge_buffers[level];
+    buffer.clear(
+      (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+      (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+      (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+    buffer.reserve(mesh.number_of_vertices(), 2 * mesh.number_of_edges());
+    std::vector<std::uint32_t> to_buffer(mesh.num_vertices(), 0);
+    BOOST_FOREACH(const vertex_descriptor v, vertices(mesh)) {
+      to_buffer[std::size_t(v)] = static_cast<std::uint32_t>(buffer.size());
+      buffer.add_vertex(mesh.point(v), 0, 0, 0);
+    }
+    // shuffled so that any prefix of the edges is spread over the mesh
+    std::vector<Surface_mesh::Edge_index> shuffled(edges(mesh).begin(), edges(mesh).end());
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(unsigned(level)));
+    for (const Surface_mesh::Edge_index e : shuffled) {
+      buffer.add_index(to_buffer[std::size_t(source(e, mesh))]);
+      buffer.add_index(to_buffer[std::size_t(target(e, mesh))]);
+    }
   }
-  ::glEnd();
+}
+
+void Scene::select_lod(const double screen_size)
+{
+  m_lod = 0;
+  if (!m_mesh || m_lods.empty())
+    return;
+
+  // finest level with at most one face per lod_pixels_per_face pixels
+  const double budget = screen_size * screen_size / lod_pixels_per_face;
+  for (m_lod = 0; m_lod < m_lods.size(); ++m_lod) {
+    const Surface_mesh *mesh = m_lod == 0 ? m_mesh : m_lods[m_lod - 1];
+    if (double(mesh->number_of_faces()) <= budget)
+      break;
+  }
+}
+
+std::size_t Scene::nb_vertex_splits() const
+{
+  return m_progressive_mesh ? m_progressive_mesh->nb_splits() : 0;
+}
+
+void Scene::set_progressive_level(const std::size_t level)
+{
+  if (m_progressive_mesh && level != m_progressive_mesh->level()) {
+    m_progressive_mesh->set_level(level);
+    m_is_progressive_dirty = true;
+  }
+}
+
+void Scene::render_progressive_mesh()
+{
+  if (m_is_progressive_dirty) {
+    // the active vertices and faces are prefixes of the arrays
+    const std::vector<Point_3> &points = m_progressive_mesh->points();
+    const std::vector<Progressive_mesh::Triangle> &triangles = m_progressive_mesh->triangles();
+    m_progressive_buffer.clear(
+      (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+      (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+      (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+    m_progressive_buffer.reserve(
+      m_progressive_mesh->nb_vertices(), 6 * m_progressive_mesh->nb_faces());
+    for (std::size_t vidx = 0; vidx < m_progressive_mesh->nb_vertices(); ++vidx)
+      m_progressive_buffer.add_vertex(points[vidx], 0, 0, 0);
+    for (std::size_t fidx = 0; fidx < m_progressive_mesh->nb_faces(); ++fidx) {
+      const Progressive_mesh::Triangle &t = triangles[fidx];
+      for (std::size_t k = 0; k < 3; ++k) {
+        m_progressive_buffer.add_index(t[k]);
+        m_progressive_buffer.add_index(t[(k + 1) % 3]);
+      }
+    }
+    m_is_progressive_dirty = false;
+  }
+
+  // draw black edges of the active faces, base faces first
+  ::glDisable(GL_LIGHTING);
+  ::glLineWidth(1.0f);
+  m_progressive_buffer.draw_prefix(GL_LINES, m_primitive_budget);
+}
+
+void Scene::delete_lods()
+{
+  for (Surface_mesh *lod : m_lods)
+    delete lod;
+  m_lods.clear();
+  m_lod = 0;
+  m_edge_buffers.clear();
 }
 
 void Scene::delete_all_algorithms()
@@ -211,6 +494,9 @@ void Scene::delete_all_algorithms()
   if (m_surface_simplification)
     delete m_surface_simplification;
   m_surface_simplification = nullptr;
+  if (m_vertex_clustering)
+    delete m_vertex_clustering;
+  m_vertex_clustering = nullptr;
   if (m_shape_detection)
     delete m_shape_detection;
   m_shape_detection = nullptr;
@@ -226,4 +512,11 @@ void Scene::delete_all_algorithms()
   if (m_ridge_detection)
     delete m_ridge_detection;
   m_ridge_detection = nullptr;
+  if (m_point_ridge_detection)
+    delete m_point_ridge_detection;
+  m_point_ridge_detection = nullptr;
+  // the progressive mesh is a result of the last simplification
+  if (m_progressive_mesh)
+    delete m_progressive_mesh;
+  m_progressive_mesh = nullptr;
 }
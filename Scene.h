@@ -3,15 +3,24 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Render_buffer.h"
+#include "Point_octree.h"
+
+#include <string>
+#include <vector>
+#include <functional>
 
 namespace Algs {
   class Surface_simplification;
+  class Vertex_clustering;
   class Shape_detection;
   class Horizontal_plane_detection;
   class Unit_normal_detection;
   class Symmetric_normal_detection;
   class Ridge_detection;
+  class Point_ridge_detection;
 }
+class Progressive_mesh;
 
 class Scene
 {
@@ -33,7 +42,13 @@ public:
 
   // algorithms
   // triangulated surface mesh simplification algorithm
-  int surface_simplification(const std::string &fname);
+  int surface_simplification(
+    const std::string &fname,
+    const Params::Surface_simplification &params,
+    const std::function<void(const std::string &)> &progress);
+
+  // Linear time vertex clustering simplification
+  int vertex_clustering(const std::string &fname, const Params::Vertex_clustering &params);
 
   // RANSAC shape detection on point cloud algorithm
   int shape_detection(const std::string &fname, const Params::Shape_detection &params);
@@ -50,31 +65,94 @@ public:
     const bool is_constrained);
 
   // Ridge approximation
-  int ridge_detection(const std::string &fname);
+  int ridge_detection(const std::string &fname, const Params::Ridge_detection &params);
+
+  // Curvature and sharp features on point cloud
+  int point_ridge_detection(const std::string &fname, const Params::Point_ridge_detection &params);
 
   // rendering
   void draw(); 
-  void render_polyhedron();
+  void render_mesh();
+
+  // pick the level of detail for a projected scene of screen_size pixels
+  void select_lod(const double screen_size);
+
+  // camera of the next draw, for the point clouds level of detail
+  void set_point_view(const Point_view &view) { m_point_view = view; }
+
+  // maximum number of primitives drawn per buffer, mesh edges, faces or ridge
+  // segments, 0 for no limit
+  void set_primitive_budget(const std::size_t budget) { m_primitive_budget = budget; }
+
+  // time and work of one part of the last timed draw
+  struct Draw_stats {
+    std::string name;
+    double ms;
+    Render_buffer::Stats work;
+  };
+
+  // time each part of the next draws, waiting for the GPU in between
+  void set_draw_timing(const bool is_timing) { m_is_timing_draws = is_timing; }
+
+  const std::vector<Draw_stats> &draw_stats() const { return m_draw_stats; }
+
+  // progressive mesh resolution, in vertex splits from its base mesh
+  std::size_t nb_vertex_splits() const;
+  void set_progressive_level(const std::size_t level);
+  void render_progressive_mesh();
 
 private:
   // avoid rendering interference
   void delete_all_algorithms();
 
+  void delete_lods();
+
+  // the mesh of fname, only read if another mesh is loaded
+  Surface_mesh *load_mesh(const std::string &fname);
+
+  void update_bbox();
+
+  // edges of the mesh and of its levels of detail, rebuilt when they change
+  void build_edge_buffers();
+
+  // draw, to the draw statistics if timing
+  void timed_draw(const char *name, const std::function<void()> &draw);
+
 private:
-  // member data
-  Polyhedron *m_pPolyhedron;
+  // member data, the mesh shared by the algorithms and the rendering
+  Surface_mesh *m_mesh;
+  // file of the loaded mesh, empty if it has no file
+  std::string m_fname;
   Bbox_3 m_bbox;
 
+  // coarser levels of detail of the mesh, and the displayed level
+  std::vector<Surface_mesh *> m_lods;
+  std::size_t m_lod;
+  // edges of each level, the mesh first
+  std::vector<Render_buffer> m_edge_buffers;
+
+  // recorded by the last simplification
+  Progressive_mesh *m_progressive_mesh;
+  // edges of the current resolution, rebuilt at the next draw once the level changed
+  Render_buffer m_progressive_buffer;
+  bool m_is_progressive_dirty;
+
   // view options
   bool m_view_polyhedron;
+  Point_view m_point_view;
+  std::size_t m_primitive_budget;
+  bool m_is_timing_draws;
+  std::vector<Draw_stats> m_draw_stats;
 
   // algorithms
   Algs::Surface_simplification *m_surface_simplification;
+  Algs::Vertex_clustering *m_vertex_clustering;
   Algs::Shape_detection *m_shape_detection;
   Algs::Horizontal_plane_detection *m_horizontal_plane_detection;
   Algs::Unit_normal_detection *m_unit_normal_detection;
   Algs::Symmetric_normal_detection *m_symmetric_normal_detection;
   Algs::Ridge_detection *m_ridge_detection;
+  Algs::Point_ridge_detection *m_point_ridge_detection;
 }; // end class Scene
 
 
@@ -12,6 +12,32 @@ void Settings_dialog::loadFromSettings()
   QSettings settings("settings.ini", QSettings::IniFormat);
   settings.beginGroup("AlgVis");
 
+  if (settings.contains("surface_simplification_stop"))
+    surface_simplification_stop->setCurrentIndex(settings.value("surface_simplification_stop").toInt());
+  if (settings.contains("surface_simplification_nb_faces"))
+    surface_simplification_nb_faces->setValue(settings.value("surface_simplification_nb_faces").toInt());
+  if (settings.contains("surface_simplification_ratio"))
+    surface_simplification_ratio->setValue(settings.value("surface_simplification_ratio").toDouble());
+  if (settings.contains("surface_simplification_max_error"))
+    surface_simplification_max_error->setValue(settings.value("surface_simplification_max_error").toDouble());
+  if (settings.contains("surface_simplification_lindstrom_turk"))
+    surface_simplification_lindstrom_turk->setChecked(settings.value("surface_simplification_lindstrom_turk").toBool());
+  if (settings.contains("surface_simplification_progressive"))
+    surface_simplification_progressive->setChecked(settings.value("surface_simplification_progressive").toBool());
+  if (settings.contains("surface_simplification_region_faces"))
+    surface_simplification_region_faces->setValue(settings.value("surface_simplification_region_faces").toInt());
+  if (settings.contains("surface_simplification_cluster_resolution"))
+    surface_simplification_cluster_resolution->setValue(settings.value("surface_simplification_cluster_resolution").toInt());
+  if (settings.contains("surface_simplification_memory_budget"))
+    surface_simplification_memory_budget->setValue(settings.value("surface_simplification_memory_budget").toInt());
+  if (settings.contains("surface_simplification_error_samples"))
+    surface_simplification_error_samples->setValue(settings.value("surface_simplification_error_samples").toInt());
+  if (settings.contains("surface_simplification_nb_lods"))
+    surface_simplification_nb_lods->setValue(settings.value("surface_simplification_nb_lods").toInt());
+
+  if (settings.contains("vertex_clustering_resolution"))
+    vertex_clustering_resolution->setValue(settings.value("vertex_clustering_resolution").toInt());
+
   if (settings.contains("shape_detection_probability"))
     shape_detection_probability->setValue(settings.value("shape_detection_probability").toDouble());
   if (settings.contains("shape_detection_min_points"))
@@ -58,6 +84,22 @@ void Settings_dialog::loadFromSettings()
   if (settings.contains("snormal_detection_is_constrained"))
     snormal_detection_is_constrained->setChecked(settings.value("snormal_detection_is_constrained").toBool());
 
+  if (settings.contains("ridge_detection_nb_rings"))
+    ridge_detection_nb_rings->setValue(settings.value("ridge_detection_nb_rings").toInt());
+  if (settings.contains("ridge_detection_nb_points"))
+    ridge_detection_nb_points->setValue(settings.value("ridge_detection_nb_points").toInt());
+  if (settings.contains("ridge_detection_nb_scales"))
+    ridge_detection_nb_scales->setValue(settings.value("ridge_detection_nb_scales").toInt());
+  if (settings.contains("ridge_detection_umb_size"))
+    ridge_detection_umb_size->setValue(settings.value("ridge_detection_umb_size").toDouble());
+  if (settings.contains("ridge_detection_patch_size"))
+    ridge_detection_patch_size->setValue(settings.value("ridge_detection_patch_size").toInt());
+
+  if (settings.contains("pridge_detection_nb_neighbors"))
+    pridge_detection_nb_neighbors->setValue(settings.value("pridge_detection_nb_neighbors").toInt());
+  if (settings.contains("pridge_detection_sharpness_ratio"))
+    pridge_detection_sharpness_ratio->setValue(settings.value("pridge_detection_sharpness_ratio").toDouble());
+
   settings.endGroup();
 }
 
@@ -66,6 +108,20 @@ void Settings_dialog::saveToSettings()
   QSettings settings("settings.ini", QSettings::IniFormat);
   settings.beginGroup("AlgVis");
 
+  settings.setValue("surface_simplification_stop", surface_simplification_stop->currentIndex());
+  settings.setValue("surface_simplification_nb_faces", surface_simplification_nb_faces->value());
+  settings.setValue("surface_simplification_ratio", surface_simplification_ratio->value());
+  settings.setValue("surface_simplification_max_error", surface_simplification_max_error->value());
+  settings.setValue("surface_simplification_lindstrom_turk", surface_simplification_lindstrom_turk->isChecked());
+  settings.setValue("surface_simplification_progressive", surface_simplification_progressive->isChecked());
+  settings.setValue("surface_simplification_region_faces", surface_simplification_region_faces->value());
+  settings.setValue("surface_simplification_cluster_resolution", surface_simplification_cluster_resolution->value());
+  settings.setValue("surface_simplification_memory_budget", surface_simplification_memory_budget->value());
+  settings.setValue("surface_simplification_error_samples", surface_simplification_error_samples->value());
+  settings.setValue("surface_simplification_nb_lods", surface_simplification_nb_lods->value());
+
+  settings.setValue("vertex_clustering_resolution", vertex_clustering_resolution->value());
+
   settings.setValue("shape_detection_min_points", shape_detection_min_points->value());
   settings.setValue("shape_detection_epsilon", shape_detection_epsilon->value());
   settings.setValue("shape_detection_normal_threshold", shape_detection_normal_threshold->value());
@@ -91,6 +147,15 @@ void Settings_dialog::saveToSettings()
   settings.setValue("snormal_detection_probability", snormal_detection_probability->value());
   settings.setValue("snormal_detection_is_constrained", snormal_detection_is_constrained->isChecked());
 
+  settings.setValue("ridge_detection_nb_rings", ridge_detection_nb_rings->value());
+  settings.setValue("ridge_detection_nb_points", ridge_detection_nb_points->value());
+  settings.setValue("ridge_detection_nb_scales", ridge_detection_nb_scales->value());
+  settings.setValue("ridge_detection_umb_size", ridge_detection_umb_size->value());
+  settings.setValue("ridge_detection_patch_size", ridge_detection_patch_size->value());
+
+  settings.setValue("pridge_detection_nb_neighbors", pridge_detection_nb_neighbors->value());
+  settings.setValue("pridge_detection_sharpness_ratio", pridge_detection_sharpness_ratio->value());
+
   settings.endGroup();
 }
 
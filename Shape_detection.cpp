@@ -164,9 +164,54 @@ void Shape_detection::detect(const std::string &fname, const Params::Shape_detec
   std::srand(static_cast<unsigned int>(std::time(nullptr)));
   for (std::size_t &c : m_shape_colors)
     c = static_cast<std::size_t>(std::rand() % 255);
+
+  build_buffers();
 }
 
-void Shape_detection::draw()
+void Shape_detection::build_buffers()
+{
+  const double cx = (m_bbox.xmin() + m_bbox.xmax()) / 2.0;
+  const double cy = (m_bbox.ymin() + m_bbox.ymax()) / 2.0;
+  const double cz = (m_bbox.zmin() + m_bbox.zmax()) / 2.0;
+  m_hull_buffer.clear(cx, cy, cz);
+  m_outline_buffer.clear(cx, cy, cz);
+  std::size_t nb_vertices = 0;
+  for (const auto &cvh : m_convex_hulls)
+    nb_vertices += cvh.size();
+  m_hull_buffer.reserve(nb_vertices, 3 * nb_vertices);
+  m_outline_buffer.reserve(nb_vertices, 2 * nb_vertices);
+
+  for (std::size_t sidx = 0; sidx < m_convex_hulls.size(); ++sidx) {
+    const auto &cvh = m_convex_hulls[sidx];
+    const std::size_t cidx = m_shape_colors[sidx];
+    const unsigned char r = Color_256::r(cidx);
+    const unsigned char g = Color_256::g(cidx);
+    const unsigned char b = Color_256::b(cidx);
+
+    // the hulls are convex and planar, a fan with the normal of its first corner
+    if (cvh.size() > 2) {
+      Kernel2::Vector_3 n = CGAL::cross_product(cvh[1] - cvh[0], cvh[2] - cvh[0]);
+      const double len = std::sqrt(n.squared_length());
+      if (len > 0.0)
+        n = n / len;
+      const std::size_t first = m_hull_buffer.size();
+      for (const auto &p : cvh)
+        m_hull_buffer.add_vertex(p, n, r, g, b, 200);
+      m_hull_buffer.add_triangle_fan(first, cvh.size());
+    }
+
+    const std::size_t first = m_outline_buffer.size();
+    for (const auto &p : cvh)
+      m_outline_buffer.add_vertex(p, r, g, b, 200);
+    m_outline_buffer.add_line_loop(first, cvh.size());
+  }
+
+  // any prefix of the primitives is spread over the shapes
+  m_hull_buffer.shuffle_primitives(3);
+  m_outline_buffer.shuffle_primitives(2);
+}
+
+void Shape_detection::draw(const std::size_t max_primitives)
 {
   if (m_points.empty())
     return;
@@ -192,31 +237,14 @@ void Shape_detection::draw()
   // ::glEnd();
 
   // draw boundary
-  for (std::size_t sidx = 0; sidx < m_convex_hulls.size(); ++sidx) {
-    const auto &cvh = m_convex_hulls[sidx];
-    const std::size_t cidx = m_shape_colors[sidx];
-    ::glColor4ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx), 200);
-    ::glBegin(GL_LINE_LOOP);
-    for (const auto &p : cvh)
-      ::glVertex3d(p.x(), p.y(), p.z());
-    ::glEnd();
-  }
+  m_outline_buffer.draw_prefix(GL_LINES, max_primitives);
 
   // draw convex hull of shape points
   ::glEnable(GL_LIGHTING);
   ::glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   ::glEnable(GL_BLEND);
   ::glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  for (std::size_t sidx = 0; sidx < m_convex_hulls.size(); ++sidx) {
-    const auto &cvh = m_convex_hulls[sidx];
-    const std::size_t cidx = m_shape_colors[sidx];
-    ::glColor4ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx), 200);
-    ::glBegin(GL_POLYGON);
-    // ::glBegin(GL_LINE_LOOP);
-    for (const auto &p : cvh)
-      ::glVertex3d(p.x(), p.y(), p.z());
-    ::glEnd();
-  }
+  m_hull_buffer.draw_prefix(GL_TRIANGLES, max_primitives, true);
 }
 
 } // Algs
@@ -9,6 +9,7 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Render_buffer.h"
 
 namespace Algs {
 
@@ -28,7 +29,12 @@ public:
 
   const Bbox_3 &bbox() { return m_bbox; }
 
-  void draw();
+  // at most max_primitives hull triangles and outline edges, 0 for no limit
+  void draw(const std::size_t max_primitives);
+
+private:
+  // triangulated hulls and their outlines to the render buffers
+  void build_buffers();
 
 private:
   Bbox_3 m_bbox;
@@ -42,6 +48,9 @@ private:
 
   // convex hulls of shape points
   std::vector<std::vector<Kernel2::Point_3>> m_convex_hulls;
+  // hull fans and outlines of all shapes, colored by shape
+  Render_buffer m_hull_buffer;
+  Render_buffer m_outline_buffer;
 };
 
 } // namespace Algs
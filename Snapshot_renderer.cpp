@@ -0,0 +1,249 @@
+#include "Snapshot_renderer.h"
+#include "Scene.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include <QImage>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <gl/gl.h>
+
+#ifdef ALG_VIS_EGL
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glext.h>
+#endif
+
+// vertical field of view of the viewer camera
+const double field_of_view = 3.14159265358979323846 / 4.0;
+
+#ifdef ALG_VIS_EGL
+// framebuffer object functions of OpenGL 3.0, resolved with a current context
+static PFNGLGENFRAMEBUFFERSPROC gen_framebuffers = nullptr;
+static PFNGLDELETEFRAMEBUFFERSPROC delete_framebuffers = nullptr;
+static PFNGLBINDFRAMEBUFFERPROC bind_framebuffer = nullptr;
+static PFNGLCHECKFRAMEBUFFERSTATUSPROC check_framebuffer_status = nullptr;
+static PFNGLFRAMEBUFFERRENDERBUFFERPROC framebuffer_renderbuffer = nullptr;
+static PFNGLGENRENDERBUFFERSPROC gen_renderbuffers = nullptr;
+static PFNGLDELETERENDERBUFFERSPROC delete_renderbuffers = nullptr;
+static PFNGLBINDRENDERBUFFERPROC bind_renderbuffer = nullptr;
+static PFNGLRENDERBUFFERSTORAGEPROC renderbuffer_storage = nullptr;
+
+template <typename Function>
+static bool resolve(Function &function, const char *name)
+{
+  function = reinterpret_cast<Function>(eglGetProcAddress(name));
+  return function != nullptr;
+}
+
+Snapshot_renderer::Snapshot_renderer() :
+  m_width(0), m_height(0), m_display(EGL_NO_DISPLAY), m_context(EGL_NO_CONTEXT), m_fbo(0)
+{
+  m_renderbuffers[0] = m_renderbuffers[1] = 0;
+}
+
+Snapshot_renderer::~Snapshot_renderer()
+{
+  if (m_context != EGL_NO_CONTEXT) {
+    if (m_fbo && eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+      delete_renderbuffers(2, m_renderbuffers);
+      delete_framebuffers(1, &m_fbo);
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_display, m_context);
+  }
+  if (m_display != EGL_NO_DISPLAY)
+    eglTerminate(m_display);
+}
+
+bool Snapshot_renderer::initialize(const int width, const int height)
+{
+  m_width = width;
+  m_height = height;
+
+  // the Mesa surfaceless platform needs neither a display nor a GPU
+  const PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  EGLDisplay display = get_platform_display ? get_platform_display(
+    EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+  if (display == EGL_NO_DISPLAY)
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    std::cerr << "unable to initialize EGL" << std::endl;
+    return false;
+  }
+  m_display = display;
+
+  // the fixed function pipeline of the viewer, drawn without a surface
+  const EGLint config_attributes[] = {
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_SURFACE_TYPE, 0,
+    EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint nb_configs = 0;
+  if (!eglBindAPI(EGL_OPENGL_API)
+    || !eglChooseConfig(display, config_attributes, &config, 1, &nb_configs)
+    || nb_configs == 0
+    || (m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr)) == EGL_NO_CONTEXT
+    || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+    std::cerr << "unable to create a surfaceless OpenGL context" << std::endl;
+    return false;
+  }
+
+  if (!resolve(gen_framebuffers, "glGenFramebuffers")
+    || !resolve(delete_framebuffers, "glDeleteFramebuffers")
+    || !resolve(bind_framebuffer, "glBindFramebuffer")
+    || !resolve(check_framebuffer_status, "glCheckFramebufferStatus")
+    || !resolve(framebuffer_renderbuffer, "glFramebufferRenderbuffer")
+    || !resolve(gen_renderbuffers, "glGenRenderbuffers")
+    || !resolve(delete_renderbuffers, "glDeleteRenderbuffers")
+    || !resolve(bind_renderbuffer, "glBindRenderbuffer")
+    || !resolve(renderbuffer_storage, "glRenderbufferStorage")) {
+    std::cerr << "no framebuffer objects in OpenGL " << ::glGetString(GL_VERSION) << std::endl;
+    return false;
+  }
+
+  gen_framebuffers(1, &m_fbo);
+  bind_framebuffer(GL_FRAMEBUFFER, m_fbo);
+  gen_renderbuffers(2, m_renderbuffers);
+  bind_renderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+  renderbuffer_storage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+  framebuffer_renderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+  bind_renderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+  renderbuffer_storage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+  framebuffer_renderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+  bind_renderbuffer(GL_RENDERBUFFER, 0);
+  const bool is_complete = check_framebuffer_status(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  bind_framebuffer(GL_FRAMEBUFFER, 0);
+  if (!is_complete) {
+    std::cerr << "unable to create a " << m_width << "x" << m_height
+      << " framebuffer" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+#else
+Snapshot_renderer::Snapshot_renderer() : m_width(0), m_height(0) {}
+
+Snapshot_renderer::~Snapshot_renderer()
+{
+  // the framebuffer is released in its context
+  if (m_fbo && m_context.makeCurrent(&m_surface))
+    m_fbo.reset();
+}
+
+bool Snapshot_renderer::initialize(const int width, const int height)
+{
+  m_width = width;
+  m_height = height;
+
+  // the fixed function pipeline of the viewer
+  QSurfaceFormat format;
+  format.setVersion(2, 1);
+  format.setProfile(QSurfaceFormat::CompatibilityProfile);
+  format.setDepthBufferSize(24);
+  m_surface.setFormat(format);
+  m_surface.create();
+  m_context.setFormat(format);
+  if (!m_surface.isValid() || !m_context.create() || !m_context.makeCurrent(&m_surface)) {
+    std::cerr << "unable to create an offscreen OpenGL context" << std::endl;
+    return false;
+  }
+
+  QOpenGLFramebufferObjectFormat fbo_format;
+  fbo_format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  m_fbo.reset(new QOpenGLFramebufferObject(m_width, m_height, fbo_format));
+  if (!m_fbo->isValid()) {
+    std::cerr << "unable to create a " << m_width << "x" << m_height
+      << " framebuffer" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+#endif
+
+bool Snapshot_renderer::render(Scene &scene, const std::string &fname)
+{
+#ifdef ALG_VIS_EGL
+  if (!m_fbo || !eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+    return false;
+  bind_framebuffer(GL_FRAMEBUFFER, m_fbo);
+#else
+  if (!m_fbo || !m_context.makeCurrent(&m_surface))
+    return false;
+  m_fbo->bind();
+#endif
+
+  ::glViewport(0, 0, m_width, m_height);
+  ::glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+  ::glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  ::glEnable(GL_DEPTH_TEST);
+  ::glEnable(GL_LIGHT0);
+  ::glEnable(GL_LIGHTING);
+  ::glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+  ::glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+  ::glEnable(GL_COLOR_MATERIAL);
+
+  // the whole bbox sphere in view, looking down -z as the viewer does
+  const Bbox_3 &bbox = scene.bbox();
+  const double center[3] = {
+    (bbox.xmin() + bbox.xmax()) / 2.0,
+    (bbox.ymin() + bbox.ymax()) / 2.0,
+    (bbox.zmin() + bbox.zmax()) / 2.0};
+  const double radius = std::max(1.0e-9, std::sqrt(
+    (bbox.xmax() - bbox.xmin()) * (bbox.xmax() - bbox.xmin())
+    + (bbox.ymax() - bbox.ymin()) * (bbox.ymax() - bbox.ymin())
+    + (bbox.zmax() - bbox.zmin()) * (bbox.zmax() - bbox.zmin())) / 2.0);
+  const double aspect = double(m_width) / double(m_height);
+  const double half_tan = std::tan(field_of_view / 2.0);
+  const double distance = radius / std::sin(std::atan(half_tan * std::min(1.0, aspect)));
+  const double z_near = std::max(distance - 1.5 * radius, 0.001 * radius);
+  const double z_far = distance + 1.5 * radius;
+
+  ::glMatrixMode(GL_PROJECTION);
+  ::glLoadIdentity();
+  ::glFrustum(-z_near * half_tan * aspect, z_near * half_tan * aspect,
+    -z_near * half_tan, z_near * half_tan, z_near, z_far);
+  ::glMatrixMode(GL_MODELVIEW);
+  ::glLoadIdentity();
+  ::glTranslated(-center[0], -center[1], -center[2] - distance);
+
+  // full detail, only points below a pixel apart are thinned
+  Point_view view;
+  view.eye[0] = center[0];
+  view.eye[1] = center[1];
+  view.eye[2] = center[2] + distance;
+  view.pixel_size = 2.0 * half_tan / double(m_height);
+  scene.set_point_view(view);
+  scene.set_primitive_budget(0);
+  scene.select_lod(2.0 * radius / (view.pixel_size * distance));
+  scene.draw();
+  ::glFinish();
+
+#ifdef ALG_VIS_EGL
+  // rows from the bottom in OpenGL, from the top in the image
+  QImage image(m_width, m_height, QImage::Format_RGBA8888);
+  ::glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  ::glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, image.bits());
+  bind_framebuffer(GL_FRAMEBUFFER, 0);
+  image = image.mirrored();
+#else
+  const QImage image = m_fbo->toImage();
+  m_fbo->release();
+#endif
+  if (!image.save(QString::fromStdString(fname))) {
+    std::cerr << "unable to write file " << fname << std::endl;
+    return false;
+  }
+
+  return true;
+}
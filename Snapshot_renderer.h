@@ -0,0 +1,59 @@
+#ifndef SNAPSHOT_RENDERER_H
+#define SNAPSHOT_RENDERER_H
+
+#include <string>
+#include <memory>
+
+#ifndef ALG_VIS_EGL
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#endif
+
+class Scene;
+
+/*!
+ * \brief Render a Scene to an image without a window, for batch snapshots.
+ * The scene draws into a framebuffer object, with the default camera and
+ * lighting of the viewer framing the scene bbox. With EGL, the context is
+ * surfaceless on the Mesa software rasterizer if there is no GPU, so that
+ * neither a GPU nor a display is needed. Otherwise, it is a Qt context of
+ * an offscreen surface.
+ */
+class Snapshot_renderer {
+public:
+  Snapshot_renderer();
+
+  ~Snapshot_renderer();
+
+  /*!
+   * \brief Create the context and the framebuffer, from the GUI thread.
+   * \return false if OpenGL is not available
+   */
+  bool initialize(const int width, const int height);
+
+  /*!
+   * \brief Draw the scene and save the image, the format from the file extension.
+   * The scene buffers are uploaded to this context.
+   */
+  bool render(Scene &scene, const std::string &fname);
+
+private:
+  int m_width;
+  int m_height;
+
+#ifdef ALG_VIS_EGL
+  // EGLDisplay and EGLContext, not to include EGL with its platform headers
+  void *m_display;
+  void *m_context;
+  // the framebuffer object and its color and depth renderbuffers
+  unsigned int m_fbo;
+  unsigned int m_renderbuffers[2];
+#else
+  QOffscreenSurface m_surface;
+  QOpenGLContext m_context;
+  std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+#endif
+};
+
+#endif // SNAPSHOT_RENDERER_H
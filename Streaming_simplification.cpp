@@ -0,0 +1,469 @@
+#include "Streaming_simplification.h"
+#include "Surface_simplification.h"
+#include "Off_reader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/foreach.hpp>
+#include <CGAL/boost/graph/iterator.h>
+
+// estimated peak bytes per face of a bucket being simplified: the mesh,
+// its property maps, the map to its vertices and the collapse queue
+const std::size_t bucket_bytes_per_face = 512;
+
+// resident bytes per input vertex: position, bucket, grid cell key and
+// output index if shared
+const std::size_t resident_bytes_per_vertex =
+  3 * sizeof(double) + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+// with a maximal error, the error bounds of the input and output vertices
+const std::size_t resident_bytes_per_bound = 2 * sizeof(double);
+
+// vertex bucket flags
+const std::uint32_t unreferenced_vertex = std::numeric_limits<std::uint32_t>::max();
+const std::uint32_t shared_vertex = unreferenced_vertex - 1;
+
+// triangles of a bucket waiting to be appended to its file
+struct Bucket_buffer {
+  Bucket_buffer() : nb_faces(0), area(0.0) {}
+
+  std::string fname;
+  std::vector<std::uint32_t> triangles;
+  std::size_t nb_faces;
+  double area;
+};
+
+// resident bytes per bucket besides its buffered triangles, the file name
+// is allocated past the short string size
+const std::size_t resident_bytes_per_bucket = sizeof(Bucket_buffer) + 32;
+
+// error bounds of the vertices of an OFF file written by a pass, in vertex order
+static std::string bounds_fname(const std::string &off_fname)
+{
+  return off_fname + ".bounds";
+}
+
+static bool flush_bucket(Bucket_buffer &bucket)
+{
+  if (bucket.triangles.empty())
+    return true;
+  std::ofstream ofs(bucket.fname, std::ios::binary | std::ios::app);
+  ofs.write(reinterpret_cast<const char *>(bucket.triangles.data()),
+    bucket.triangles.size() * sizeof(std::uint32_t));
+  bucket.triangles.clear();
+  return bool(ofs);
+}
+
+namespace Algs {
+
+int Streaming_simplification::simplify(
+  const std::string &fname,
+  const std::string &out_fname,
+  const Params::Surface_simplification &params)
+{
+  // first pass over the buckets, the seams are left for the second one
+  const std::string pass_fname = out_fname + ".pass.off";
+  std::size_t nb_faces = 0, nb_pass_faces = 0;
+  std::size_t target = params.nb_faces;
+  if (params.stop == Params::Surface_simplification::EDGE_RATIO) {
+    Off_reader reader;
+    if (!reader.open(fname)) {
+      std::cerr << "invalid OFF file" << std::endl;
+      return EXIT_FAILURE;
+    }
+    target = std::size_t(params.ratio * double(reader.nb_faces()));
+  }
+  if (simplify_pass(fname, pass_fname, params, target, false, nb_faces, nb_pass_faces) != EXIT_SUCCESS) {
+    std::remove(pass_fname.c_str());
+    std::remove(bounds_fname(pass_fname).c_str());
+    return EXIT_FAILURE;
+  }
+
+  // second pass on a grid shifted by half a bucket, over the former seams
+  std::size_t nb_seam_faces = 0, nb_final_faces = 0;
+  const int r = simplify_pass(pass_fname, out_fname, params, target, true, nb_seam_faces, nb_final_faces);
+  std::remove(pass_fname.c_str());
+  std::remove(bounds_fname(pass_fname).c_str());
+  if (r != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  std::cout << "\nStreaming simplification: " << nb_faces << " -> "
+    << nb_pass_faces << " -> " << nb_final_faces << " faces" << std::endl;
+  if (m_progress) {
+    std::ostringstream oss;
+    oss << nb_final_faces << " faces left, written to " << out_fname;
+    m_progress(oss.str());
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int Streaming_simplification::simplify_pass(
+  const std::string &fname,
+  const std::string &out_fname,
+  const Params::Surface_simplification &params,
+  const std::size_t target_faces,
+  const bool is_seam_pass,
+  std::size_t &nb_faces_in,
+  std::size_t &nb_faces_out)
+{
+  const double shift = is_seam_pass ? 0.5 : 0.0;
+  // error bounds are passed from the first pass to the second one
+  const bool has_bounds = params.stop == Params::Surface_simplification::MAX_ERROR;
+
+  Off_reader reader;
+  if (!reader.open(fname)) {
+    std::cerr << "invalid OFF file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::size_t nb_vertices = reader.nb_vertices();
+  if (nb_vertices >= shared_vertex) {
+    std::cerr << "too many vertices" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // what is left of the budget once the vertices are loaded goes to the buckets
+  const std::size_t budget = params.memory_budget << 20;
+  const std::size_t resident = nb_vertices
+    * (resident_bytes_per_vertex + (has_bounds ? resident_bytes_per_bound : 0));
+  if (budget <= resident + 64 * bucket_bytes_per_face) {
+    std::cerr << "memory budget too small, at least "
+      << ((resident + 64 * bucket_bytes_per_face) >> 20) + 1 << " MB" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> positions(nb_vertices * 3);
+  double bmin[3] = {0.0, 0.0, 0.0};
+  double bmax[3] = {0.0, 0.0, 0.0};
+  for (std::size_t i = 0; i < nb_vertices; ++i) {
+    double *p = &positions[i * 3];
+    if (!reader.read_vertex(p)) {
+      std::cerr << "invalid OFF file" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (std::size_t k = 0; k < 3; ++k) {
+      bmin[k] = i == 0 ? p[k] : std::min(bmin[k], p[k]);
+      bmax[k] = i == 0 ? p[k] : std::max(bmax[k], p[k]);
+    }
+  }
+
+  // bounds left by the first pass, the input vertices have none
+  std::vector<double> bounds;
+  if (has_bounds && is_seam_pass) {
+    bounds.resize(nb_vertices);
+    std::ifstream bifs(bounds_fname(fname), std::ios::binary);
+    bifs.read(reinterpret_cast<char *>(bounds.data()), nb_vertices * sizeof(double));
+    if (!bifs) {
+      std::cerr << "unable to read the error bounds of " << fname << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  const auto input_bound = [&](const std::size_t g) {
+    return bounds.empty() ? 0.0 : bounds[g];
+  };
+
+  // bisect cubic buckets until each holds at most half of bucket_faces
+  // vertices, a mesh has about twice as many faces as vertices, the cells are
+  // counted on the sorted vertex keys, which then keep one key per bucket
+  double side = std::max(bmax[0] - bmin[0], std::max(bmax[1] - bmin[1], bmax[2] - bmin[2]));
+  if (side <= 0.0)
+    side = 1.0;
+  std::uint64_t dims[3] = {1, 1, 1};
+  double origin[3] = {bmin[0], bmin[1], bmin[2]};
+  const auto bucket_key = [&](const double *p) {
+    std::uint64_t c[3];
+    for (std::size_t k = 0; k < 3; ++k)
+      c[k] = std::min(dims[k] - 1,
+        static_cast<std::uint64_t>(std::max(0.0, (p[k] - origin[k]) / side)));
+    return (c[0] * dims[1] + c[1]) * dims[2] + c[2];
+  };
+  std::vector<std::uint64_t> keys(nb_vertices);
+  std::size_t bucket_faces = 0;
+  std::size_t available = 0;
+  while (true) {
+    for (std::size_t k = 0; k < 3; ++k) {
+      origin[k] = bmin[k] - shift * side;
+      dims[k] = static_cast<std::uint64_t>(std::floor((bmax[k] - origin[k]) / side)) + 1;
+    }
+
+    for (std::size_t i = 0; i < nb_vertices; ++i)
+      keys[i] = bucket_key(&positions[i * 3]);
+    std::sort(keys.begin(), keys.end());
+    std::size_t max_count = 0, nb_cells = 0;
+    for (std::size_t i = 0, j = 0; i < nb_vertices; i = j, ++nb_cells) {
+      while (j < nb_vertices && keys[j] == keys[i])
+        ++j;
+      max_count = std::max(max_count, j - i);
+    }
+    if (budget <= resident + nb_cells * resident_bytes_per_bucket + 64 * bucket_bytes_per_face) {
+      std::cerr << "memory budget too small for " << nb_cells << " buckets, at least "
+        << ((resident + nb_cells * resident_bytes_per_bucket + 64 * bucket_bytes_per_face) >> 20) + 1
+        << " MB" << std::endl;
+      return EXIT_FAILURE;
+    }
+    available = budget - resident - nb_cells * resident_bytes_per_bucket;
+    bucket_faces = available / bucket_bytes_per_face;
+    if (max_count * 2 <= bucket_faces || max_count <= 1 || dims[0] * dims[1] * dims[2] > (1u << 30)) {
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      break;
+    }
+    side /= 2.0;
+  }
+  // bucket of a cell key, or of its first vertex for a centroid in a cell without vertices
+  const auto key_bucket = [&](const std::uint64_t key, const std::uint64_t fallback) {
+    auto found = std::lower_bound(keys.begin(), keys.end(), key);
+    if (found == keys.end() || *found != key)
+      found = std::lower_bound(keys.begin(), keys.end(), fallback);
+    return static_cast<std::uint32_t>(found - keys.begin());
+  };
+
+  // distribute the triangles to the bucket files by centroid, the buffers
+  // are flushed once they hold a quarter of the budget
+  std::vector<Bucket_buffer> buckets(keys.size());
+  for (std::size_t b = 0; b < buckets.size(); ++b)
+    buckets[b].fname = out_fname + ".bucket" + std::to_string(b);
+  const std::size_t max_buffered = std::max<std::size_t>(1, available / 4 / sizeof(std::uint32_t));
+  std::size_t nb_buffered = 0;
+  std::vector<std::uint32_t> vertex_bucket(nb_vertices, unreferenced_vertex);
+  std::vector<std::size_t> face;
+  bool is_valid = true;
+  double total_area = 0.0;
+  nb_faces_in = 0;
+  for (std::size_t f = 0; f < reader.nb_faces() && is_valid; ++f) {
+    if (!reader.read_face(face)) {
+      std::cerr << "invalid OFF file" << std::endl;
+      is_valid = false;
+      break;
+    }
+    for (const std::size_t v : face) {
+      if (v >= nb_vertices) {
+        std::cerr << "invalid vertex index " << v << std::endl;
+        is_valid = false;
+      }
+    }
+
+    for (std::size_t j = 1; is_valid && j + 1 < face.size(); ++j) {
+      const std::size_t tri[3] = {face[0], face[j], face[j + 1]};
+      double centroid[3];
+      for (std::size_t k = 0; k < 3; ++k)
+        centroid[k] = (positions[tri[0] * 3 + k] + positions[tri[1] * 3 + k]
+          + positions[tri[2] * 3 + k]) / 3.0;
+      const std::uint32_t b = key_bucket(bucket_key(centroid), bucket_key(&positions[tri[0] * 3]));
+
+      const double *p0 = &positions[tri[0] * 3];
+      const double *p1 = &positions[tri[1] * 3];
+      const double *p2 = &positions[tri[2] * 3];
+      const double u[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      const double w[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      const double n[3] = {
+        u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2], u[0] * w[1] - u[1] * w[0]};
+      const double area = 0.5 * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      buckets[b].area += area;
+      total_area += area;
+
+      for (const std::size_t v : tri) {
+        buckets[b].triangles.push_back(static_cast<std::uint32_t>(v));
+        if (vertex_bucket[v] == unreferenced_vertex)
+          vertex_bucket[v] = b;
+        else if (vertex_bucket[v] != b)
+          vertex_bucket[v] = shared_vertex;
+      }
+      ++buckets[b].nb_faces;
+      ++nb_faces_in;
+
+      nb_buffered += 3;
+      if (nb_buffered >= max_buffered) {
+        for (Bucket_buffer &bucket : buckets)
+          is_valid = flush_bucket(bucket) && is_valid;
+        nb_buffered = 0;
+      }
+    }
+  }
+  reader.close();
+  // the buffers are released, their quarter of the budget goes to the buckets
+  for (Bucket_buffer &bucket : buckets) {
+    is_valid = flush_bucket(bucket) && is_valid;
+    std::vector<std::uint32_t>().swap(bucket.triangles);
+  }
+  if (!is_valid) {
+    for (const Bucket_buffer &bucket : buckets)
+      std::remove(bucket.fname.c_str());
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "\nSimplifying " << buckets.size() << " buckets of "
+    << nb_faces_in << " faces, at most " << bucket_faces << " faces per bucket..." << std::endl;
+
+  // simplify the buckets one at a time, vertices shared between buckets
+  // are fixed and numbered once in the output
+  const std::string vertices_fname = out_fname + ".vertices";
+  const std::string faces_fname = out_fname + ".faces";
+  std::ofstream vertices_ofs(vertices_fname);
+  std::ofstream faces_ofs(faces_fname);
+  vertices_ofs.precision(17);
+  // output index of the fixed vertices, by input vertex
+  std::vector<std::uint32_t> fixed_index(nb_vertices, unreferenced_vertex);
+  std::size_t nb_out_vertices = 0;
+  // error bounds of the output vertices, for the second pass
+  std::vector<double> out_bounds;
+  const bool is_writing_bounds = has_bounds && !is_seam_pass;
+  nb_faces_out = 0;
+  const auto out_vertex = [&](const Point_3 &p, const double bound) {
+    vertices_ofs << p.x() << ' ' << p.y() << ' ' << p.z() << '\n';
+    if (is_writing_bounds)
+      out_bounds.push_back(bound);
+    return nb_out_vertices++;
+  };
+  // a vertex shared by several buckets keeps its largest bound
+  const auto out_fixed_vertex = [&](const std::size_t g, const double bound) {
+    const std::size_t found = fixed_index[g];
+    if (found != unreferenced_vertex) {
+      if (is_writing_bounds)
+        out_bounds[found] = std::max(out_bounds[found], bound);
+      return found;
+    }
+    const double *p = &positions[g * 3];
+    const std::size_t index = out_vertex(Point_3(p[0], p[1], p[2]), bound);
+    // no more output than input vertices, the index fits
+    fixed_index[g] = static_cast<std::uint32_t>(index);
+    return index;
+  };
+
+  for (std::size_t b = 0; b < buckets.size(); ++b) {
+    std::vector<std::uint32_t> triangles(buckets[b].nb_faces * 3);
+    std::ifstream ifs(buckets[b].fname, std::ios::binary);
+    ifs.read(reinterpret_cast<char *>(triangles.data()), triangles.size() * sizeof(std::uint32_t));
+    ifs.close();
+    std::remove(buckets[b].fname.c_str());
+
+    // bucket mesh, the faces it rejects are kept as is
+    Surface_mesh mesh;
+    auto fixed = mesh.add_property_map<vertex_descriptor, bool>("v:fixed", false).first;
+    auto gid = mesh.add_property_map<vertex_descriptor, std::size_t>(
+      "v:gid", std::numeric_limits<std::size_t>::max()).first;
+    // continued by the bounded error placement of the regions
+    auto vertex_bounds = mesh.add_property_map<vertex_descriptor, double>("v:error", 0.0).first;
+    std::unordered_map<std::size_t, vertex_descriptor> to_local;
+    std::vector<std::size_t> failed;
+    for (std::size_t t = 0; t < triangles.size(); t += 3) {
+      vertex_descriptor vs[3];
+      for (std::size_t k = 0; k < 3; ++k) {
+        const std::size_t g = triangles[t + k];
+        const auto inserted = to_local.insert(std::make_pair(g, vertex_descriptor()));
+        if (inserted.second) {
+          const double *p = &positions[g * 3];
+          inserted.first->second = mesh.add_vertex(Point_3(p[0], p[1], p[2]));
+          put(gid, inserted.first->second, g);
+          put(fixed, inserted.first->second, vertex_bucket[g] == shared_vertex);
+          put(vertex_bounds, inserted.first->second, input_bound(g));
+        }
+        vs[k] = inserted.first->second;
+      }
+      if (mesh.add_face(vs[0], vs[1], vs[2]) == Surface_mesh::null_face())
+        failed.push_back(t);
+    }
+    // vertices of the rejected faces stay in place
+    for (const std::size_t t : failed)
+      for (std::size_t k = 0; k < 3; ++k)
+        put(fixed, to_local[triangles[t + k]], true);
+
+    Params::Surface_simplification bucket_params = params;
+    bool is_simplified = true;
+    if (params.stop != Params::Surface_simplification::MAX_ERROR) {
+      // share of the target by surface area, the density of the input around the
+      // bucket whatever the former seams it holds
+      const double share = total_area > 0.0 ? buckets[b].area / total_area
+        : double(buckets[b].nb_faces) / double(nb_faces_in);
+      const double nb_faces = double(mesh.number_of_faces());
+      double bucket_target = double(target_faces) * share;
+      if (!is_seam_pass) {
+        // the faces on the seams are left at full resolution for the second pass
+        std::size_t nb_seam_faces = 0;
+        for (const face_descriptor f : mesh.faces())
+          BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(mesh.halfedge(f), mesh))
+            if (get(fixed, v)) {
+              ++nb_seam_faces;
+              break;
+            }
+        const double ratio = nb_faces == 0.0 ? 1.0 : std::min(1.0, bucket_target / nb_faces);
+        bucket_target = ratio * (nb_faces - double(nb_seam_faces)) + double(nb_seam_faces);
+      }
+      bucket_params.stop = Params::Surface_simplification::FACE_BUDGET;
+      bucket_params.nb_faces = std::size_t(std::ceil(bucket_target));
+      is_simplified = bucket_params.nb_faces < mesh.number_of_faces();
+    }
+    if (is_simplified)
+      Surface_simplification::simplify_region(mesh, bucket_params);
+
+    // write the bucket out
+    std::vector<std::size_t> out_index(mesh.num_vertices(), 0);
+    for (const vertex_descriptor v : mesh.vertices()) {
+      if (mesh.is_isolated(v))
+        continue;
+      out_index[std::size_t(v)] = get(fixed, v) ?
+        out_fixed_vertex(get(gid, v), get(vertex_bounds, v))
+        : out_vertex(mesh.point(v), get(vertex_bounds, v));
+    }
+    for (const face_descriptor f : mesh.faces()) {
+      faces_ofs << '3';
+      BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(mesh.halfedge(f), mesh))
+        faces_ofs << ' ' << out_index[std::size_t(v)];
+      faces_ofs << '\n';
+      ++nb_faces_out;
+    }
+    for (const std::size_t t : failed) {
+      faces_ofs << "3 " << out_fixed_vertex(triangles[t], input_bound(triangles[t])) << ' '
+        << out_fixed_vertex(triangles[t + 1], input_bound(triangles[t + 1])) << ' '
+        << out_fixed_vertex(triangles[t + 2], input_bound(triangles[t + 2])) << '\n';
+      ++nb_faces_out;
+    }
+
+    if (m_progress) {
+      std::ostringstream oss;
+      oss << "Buckets simplified: " << b + 1 << " / " << buckets.size();
+      m_progress(oss.str());
+    }
+  }
+  vertices_ofs.close();
+  faces_ofs.close();
+
+  // header, then the vertices and faces written so far
+  std::ofstream ofs(out_fname);
+  ofs << "OFF\n" << nb_out_vertices << ' ' << nb_faces_out << " 0\n";
+  std::ifstream vertices_ifs(vertices_fname);
+  if (nb_out_vertices != 0)
+    ofs << vertices_ifs.rdbuf();
+  vertices_ifs.close();
+  std::ifstream faces_ifs(faces_fname);
+  if (nb_faces_out != 0)
+    ofs << faces_ifs.rdbuf();
+  faces_ifs.close();
+  std::remove(vertices_fname.c_str());
+  std::remove(faces_fname.c_str());
+  if (!ofs) {
+    std::cerr << "unable to write file " << out_fname << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (is_writing_bounds) {
+    std::ofstream bofs(bounds_fname(out_fname), std::ios::binary);
+    bofs.write(reinterpret_cast<const char *>(out_bounds.data()),
+      out_bounds.size() * sizeof(double));
+    if (!bofs) {
+      std::cerr << "unable to write file " << bounds_fname(out_fname) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+} // Algs
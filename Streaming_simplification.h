@@ -0,0 +1,59 @@
+#ifndef STREAMING_SIMPLIFICATION_H
+#define STREAMING_SIMPLIFICATION_H
+
+#include "types.h"
+#include "parameters.h"
+
+#include <string>
+#include <functional>
+
+namespace Algs {
+
+/************************************************************************/
+/* Streaming Out-of-core Surface Simplification                         */
+/* The faces are distributed to spatial buckets on disk, each bucket is */
+/* simplified in memory with its seams fixed, then the seams on a grid  */
+/* shifted by half a bucket                                             */
+/************************************************************************/
+class Streaming_simplification {
+public:
+  typedef std::function<void(const std::string &)> Progress_callback;
+
+  Streaming_simplification() {}
+
+  void set_progress(const Progress_callback &progress) { m_progress = progress; }
+
+  /*!
+   * \brief Simplify the OFF file fname into out_fname within params.memory_budget.
+   * Only the input vertex positions, bucket ids, grid cell keys and output
+   * indices stay in memory, about 40 bytes per vertex, 56 with a maximal
+   * error, the faces are streamed and the output written bucket by bucket.
+   * \return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int simplify(const std::string &fname,
+    const std::string &out_fname,
+    const Params::Surface_simplification &params);
+
+private:
+  /*!
+   * \brief One pass over the buckets of a grid, shifted by half a bucket for
+   * the seam pass. The buckets share the target_faces in proportion of their
+   * surface area, the first pass leaves the faces on the seams at full
+   * resolution for the second one. With a maximal error, the first pass
+   * writes the error bounds of its vertices and the second one continues them.
+   */
+  int simplify_pass(const std::string &fname,
+    const std::string &out_fname,
+    const Params::Surface_simplification &params,
+    const std::size_t target_faces,
+    const bool is_seam_pass,
+    std::size_t &nb_faces_in,
+    std::size_t &nb_faces_out);
+
+private:
+  Progress_callback m_progress;
+};
+
+} // namespace Algs
+
+#endif // STREAMING_SIMPLIFICATION_H
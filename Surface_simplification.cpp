@@ -5,139 +5,776 @@
 ////////////////////////////////////////////////////
 
 #include "Surface_simplification.h"
+#include "Mesh_patches.h"
+#include "Vertex_clustering.h"
+#include "Streaming_simplification.h"
+#include "Mesh_error.h"
+#include "Parallel.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/foreach.hpp>
+#include <CGAL/boost/graph/iterator.h>
+
+// each level of detail keeps a quarter of the faces of the previous one
+const std::size_t lod_face_ratio = 4;
+
+// error bound of each vertex, from the faces it replaces to the input surface
+typedef Surface_mesh::Property_map<vertex_descriptor, double> Error_bound_map;
+
+/*!
+ * \brief Error bound of the vertex placed at p by the collapse of the profile edge:
+ * the larger bound of the two edge vertices plus the distance from p to the
+ * supporting planes of the faces around the edge, so the bounds accumulate
+ * over the collapses instead of restarting from the current faces.
+ */
+template <typename Profile>
+double collapse_error_bound(
+  const Profile &profile,
+  const typename Profile::Point &p,
+  const Error_bound_map &bounds)
+{
+  double squared_distance = 0.0;
+  for (const auto &t : profile.triangles()) {
+    const Kernel::Point_3 &p0 = get(profile.vertex_point_map(), t.v0);
+    const Kernel::Point_3 &p1 = get(profile.vertex_point_map(), t.v1);
+    const Kernel::Point_3 &p2 = get(profile.vertex_point_map(), t.v2);
+    if (CGAL::collinear(p0, p1, p2))
+      continue;
+    squared_distance = std::max(squared_distance,
+      CGAL::to_double(CGAL::squared_distance(Kernel::Plane_3(p0, p1, p2), p)));
+  }
+
+  return std::max(get(bounds, profile.v0()), get(bounds, profile.v1()))
+    + std::sqrt(squared_distance);
+}
+
+/*!
+ * \brief Placement rejecting new vertices whose accumulated error bound
+ * exceeds max_error.
+ */
+template <typename Placement>
+class Bounded_error_placement {
+public:
+  Bounded_error_placement(const double max_error,
+    const Error_bound_map &bounds,
+    const Placement &placement) :
+    m_max_error(max_error), m_bounds(bounds), m_placement(placement) {}
+
+  template <typename Profile>
+  boost::optional<typename Profile::Point> operator()(const Profile &profile) const
+  {
+    const boost::optional<typename Profile::Point> op = m_placement(profile);
+    if (!op || collapse_error_bound(profile, *op, m_bounds) > m_max_error)
+      return boost::optional<typename Profile::Point>();
+    return op;
+  }
+
+private:
+  double m_max_error;
+  Error_bound_map m_bounds;
+  Placement m_placement;
+};
+
+/*!
+ * \brief Passes the events to the visitor and stores the error bound of the
+ * survivor of each collapse, measured before the faces change.
+ */
+template <typename Visitor>
+struct Error_bound_visitor : SMS::Edge_collapse_visitor_base<Surface_mesh> {
+  typedef SMS::Edge_profile<Surface_mesh> Profile;
+
+  Error_bound_visitor(Visitor &v, const Error_bound_map &b) : vis(v), bounds(b) {}
+
+  void OnStarted(Surface_mesh &mesh) { vis.OnStarted(mesh); }
+
+  void OnFinished(Surface_mesh &mesh) { vis.OnFinished(mesh); }
+
+  void OnStopConditionReached(Profile const &profile) { vis.OnStopConditionReached(profile); }
+
+  void OnCollected(Profile const &profile, boost::optional<double> const &cost)
+  {
+    vis.OnCollected(profile, cost);
+  }
+
+  void OnSelected(Profile const &profile,
+    boost::optional<double> cost,
+    std::size_t initial,
+    std::size_t current)
+  {
+    vis.OnSelected(profile, cost, initial, current);
+  }
+
+  void OnCollapsing(Profile const &profile, boost::optional<Point_3> placement)
+  {
+    if (placement)
+      bound = collapse_error_bound(profile, *placement, bounds);
+    vis.OnCollapsing(profile, placement);
+  }
+
+  void OnCollapsed(Profile const &profile, vertex_descriptor const &v)
+  {
+    put(bounds, v, bound);
+    vis.OnCollapsed(profile, v);
+  }
+
+  void OnNonCollapsable(Profile const &profile) { vis.OnNonCollapsable(profile); }
+
+  Visitor &vis;
+  Error_bound_map bounds;
+  double bound = 0.0;
+};
+
+/*!
+ * \brief Error bounds of the mesh vertices, zero for the vertices of the input.
+ */
+Error_bound_map error_bounds(Surface_mesh &mesh)
+{
+  return mesh.add_property_map<vertex_descriptor, double>("v:error", 0.0).first;
+}
+
+/*!
+ * \brief Remove a vertex property map of the simplification if the mesh has it,
+ * the mesh of a scene outlives the runs.
+ */
+template <typename T>
+void remove_vertex_map(Surface_mesh &mesh, const std::string &name)
+{
+  const auto found = mesh.property_map<vertex_descriptor, T>(name);
+  if (found.second)
+    mesh.remove_property_map(found.first);
+}
+
+/*!
+ * \brief Run the edge collapses with the stop criterion of the parameters.
+ */
+template <typename Cost, typename Placement, typename Visitor>
+int collapse_edges(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params,
+  const Cost &cost,
+  const Placement &placement,
+  Visitor &vis)
+{
+  switch (params.stop) {
+    case Params::Surface_simplification::FACE_BUDGET: {
+      // a closed triangle mesh has 3/2 edges per face
+      SMS::Count_stop_predicate<Surface_mesh> stop(params.nb_faces * 3 / 2);
+      return SMS::edge_collapse(mesh, stop,
+        CGAL::parameters::get_cost(cost).get_placement(placement).visitor(vis));
+    }
+    case Params::Surface_simplification::EDGE_RATIO: {
+      SMS::Count_ratio_stop_predicate<Surface_mesh> stop(params.ratio);
+      return SMS::edge_collapse(mesh, stop,
+        CGAL::parameters::get_cost(cost).get_placement(placement).visitor(vis));
+    }
+    default: {
+      // collapse until every remaining edge would exceed the error
+      SMS::Count_stop_predicate<Surface_mesh> stop(0);
+      const Error_bound_map bounds = error_bounds(mesh);
+      Error_bound_visitor<Visitor> bound_vis(vis, bounds);
+      return SMS::edge_collapse(mesh, stop,
+        CGAL::parameters::get_cost(cost)
+        .get_placement(Bounded_error_placement<Placement>(params.max_error, bounds, placement))
+        .visitor(bound_vis));
+    }
+  }
+}
+
+/*!
+ * \brief Run the edge collapses with the cost and placement of the parameters.
+ */
+template <typename Visitor>
+int collapse_edges(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params,
+  Visitor &vis)
+{
+  // The index maps are not explicitly passed, the default ones are the
+  // Surface_mesh indices, the mesh must be free of garbage.
+  if (params.lindstrom_turk)
+    return collapse_edges(mesh, params,
+      SMS::LindstromTurk_cost<Surface_mesh>(),
+      SMS::LindstromTurk_placement<Surface_mesh>(),
+      vis);
+  return collapse_edges(mesh, params,
+    SMS::Edge_length_cost<Surface_mesh>(),
+    SMS::Midpoint_placement<Surface_mesh>(),
+    vis);
+}
+
+/*!
+ * \brief Vertices and faces of a mesh free of garbage by their indices,
+ * polygons are triangulated as fans.
+ */
+template <typename Triangle>
+void to_triangles(
+  const Surface_mesh &mesh,
+  std::vector<Point_3> &points,
+  std::vector<Triangle> &triangles)
+{
+  typedef typename Triangle::value_type Index;
+  points.clear();
+  points.reserve(mesh.number_of_vertices());
+  BOOST_FOREACH(const vertex_descriptor v, vertices(mesh))
+    points.push_back(mesh.point(v));
+  triangles.clear();
+  triangles.reserve(mesh.number_of_faces());
+  BOOST_FOREACH(const face_descriptor f, faces(mesh)) {
+    const halfedge_descriptor h = halfedge(f, mesh);
+    for (halfedge_descriptor g = next(h, mesh); next(g, mesh) != h; g = next(g, mesh)) {
+      const Triangle t = {{
+        static_cast<Index>(std::size_t(target(h, mesh))),
+        static_cast<Index>(std::size_t(target(g, mesh))),
+        static_cast<Index>(std::size_t(target(next(g, mesh), mesh)))}};
+      triangles.push_back(t);
+    }
+  }
+}
+
+typedef Surface_mesh::Property_map<vertex_descriptor, bool> Fixed_vertex_map;
+typedef Surface_mesh::Property_map<vertex_descriptor, std::size_t> Global_id_map;
+
+/*!
+ * \brief Placement keeping the fixed vertices in place,
+ * an edge between two fixed vertices is not collapsed.
+ */
+template <typename Placement>
+class Fixed_vertex_placement {
+public:
+  Fixed_vertex_placement(const Fixed_vertex_map &fixed, const Placement &placement) :
+    m_fixed(fixed), m_placement(placement) {}
+
+  template <typename Profile>
+  boost::optional<typename Profile::Point> operator()(const Profile &profile) const
+  {
+    const bool is_fixed0 = get(m_fixed, profile.v0());
+    const bool is_fixed1 = get(m_fixed, profile.v1());
+    if (is_fixed0 && is_fixed1)
+      return boost::optional<typename Profile::Point>();
+    if (is_fixed0)
+      return boost::optional<typename Profile::Point>(profile.p0());
+    if (is_fixed1)
+      return boost::optional<typename Profile::Point>(profile.p1());
+    return m_placement(profile);
+  }
+
+private:
+  Fixed_vertex_map m_fixed;
+  Placement m_placement;
+};
+
+/*!
+ * \brief Passes the fixed flag and global id to the survivor of a collapse.
+ */
+struct Region_visitor : SMS::Edge_collapse_visitor_base<Surface_mesh> {
+  typedef SMS::Edge_profile<Surface_mesh> Profile;
+
+  Region_visitor(const Fixed_vertex_map &f, const Global_id_map &g) : fixed(f), gid(g) {}
+
+  void OnCollapsed(Profile const &profile, vertex_descriptor const &v)
+  {
+    if (get(fixed, profile.v0())) {
+      put(fixed, v, true);
+      put(gid, v, get(gid, profile.v0()));
+    }
+    else if (get(fixed, profile.v1())) {
+      put(fixed, v, true);
+      put(gid, v, get(gid, profile.v1()));
+    }
+  }
+
+  Fixed_vertex_map fixed;
+  Global_id_map gid;
+};
+
+/*!
+ * \brief Run the edge collapses of a region, fixed vertices stay in place.
+ */
+template <typename Cost, typename Placement>
+int collapse_region_edges(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params,
+  const Cost &cost,
+  const Placement &placement)
+{
+  const Fixed_vertex_map fixed =
+    mesh.add_property_map<vertex_descriptor, bool>("v:fixed", false).first;
+  const Global_id_map gid = mesh.add_property_map<vertex_descriptor, std::size_t>(
+    "v:gid", std::numeric_limits<std::size_t>::max()).first;
+  Region_visitor vis(fixed, gid);
+  const Fixed_vertex_placement<Placement> fixed_placement(fixed, placement);
+
+  if (params.stop == Params::Surface_simplification::MAX_ERROR) {
+    SMS::Count_stop_predicate<Surface_mesh> stop(0);
+    const Error_bound_map bounds = error_bounds(mesh);
+    Error_bound_visitor<Region_visitor> bound_vis(vis, bounds);
+    return SMS::edge_collapse(mesh, stop,
+      CGAL::parameters::get_cost(cost)
+      .get_placement(Bounded_error_placement<Fixed_vertex_placement<Placement>>(
+        params.max_error, bounds, fixed_placement))
+      .visitor(bound_vis));
+  }
+
+  SMS::Count_stop_predicate<Surface_mesh> stop(params.nb_faces * 3 / 2);
+  return SMS::edge_collapse(mesh, stop,
+    CGAL::parameters::get_cost(cost).get_placement(fixed_placement).visitor(vis));
+}
+
+/*!
+ * \brief Simplified region as a triangle soup, fixed vertices carry their global id.
+ */
+struct Region_soup {
+  std::vector<Point_3> points;
+  std::vector<std::size_t> gids;
+  // error bounds of the points, with a maximal error
+  std::vector<double> bounds;
+  std::vector<std::size_t> triangles;
+  // original faces left out of the region, kept as is
+  std::vector<face_descriptor> failed_faces;
+};
 
 namespace Algs {
 
-int Surface_simplification::simplify()
+int Surface_simplification::simplify(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params)
 {
-  if (m_pPolyhedron == nullptr) {
-    std::cout << "Load polyhedron first." << std::endl;
-    return EXIT_FAILURE;
+  // the input is kept as triangles to measure the error of the result
+  std::vector<Point_3> input_points;
+  std::vector<Mesh_error::Triangle> input_triangles;
+  if (params.error_samples != 0) {
+    if (mesh.has_garbage())
+      mesh.collect_garbage();
+    to_triangles(mesh, input_points, input_triangles);
   }
 
-  std::cout << "\nStarting surface simplification...\n" 
-    << m_pPolyhedron->size_of_halfedges() / 2
-    << " original undirected edges." << std::endl;
-
-  // This is a stop predicate (defines when the algorithm terminates).
-  // In this example, the simplification stops when the number of undirected edges
-  // left in the surface mesh drops below the specified number (1000)
-  SMS::Count_stop_predicate<Polyhedron> stop(14000);
-
-  // This the actual call to the simplification algorithm.
-  // The surface mesh and stop conditions are mandatory arguments.
-  // The index maps are needed because the vertices and edges
-  // of this surface mesh lack an "id()" field.
-  int r = SMS::edge_collapse
-  (*m_pPolyhedron
-    , stop
-    , CGAL::parameters::vertex_index_map(get(CGAL::vertex_external_index, *m_pPolyhedron))
-    .halfedge_index_map(get(CGAL::halfedge_external_index, *m_pPolyhedron))
-    .get_cost(SMS::Edge_length_cost<Polyhedron>())
-    .get_placement(SMS::Midpoint_placement<Polyhedron>())
-  );
+  int r = EXIT_SUCCESS;
+  if (params.region_faces != 0)
+    r = simplify_in_regions(mesh, params);
+  else if (params.nb_lods != 0)
+    r = simplify_lods(mesh, params);
+  else
+    r = simplify_serial(mesh, params);
+  if (r != EXIT_SUCCESS || params.error_samples == 0)
+    return r;
 
-  std::cout << "\nFinished...\n" << r << " edges removed.\n"
-    << ((*m_pPolyhedron).size_of_halfedges() / 2) << " final edges.\n";
+  // distances between the input and the result in both directions
+  std::cout << "\nMeasuring the error with " << params.error_samples << " samples..." << std::endl;
+  std::vector<Point_3> points;
+  std::vector<Mesh_error::Triangle> triangles;
+  to_triangles(mesh, points, triangles);
+  Mesh_error error;
+  error.measure(input_points, input_triangles, points, triangles, params.error_samples);
+  report_error(error);
 
-  std::ofstream os("out.off");
-  os << (*m_pPolyhedron);
+  return EXIT_SUCCESS;
+}
+
+int Surface_simplification::simplify(
+  const std::string &filename,
+  const Params::Surface_simplification &params)
+{
+  // the error is measured from the file, the mesh may be clustered first
+  Params::Surface_simplification file_params = params;
+  file_params.error_samples = 0;
+  const int r = simplify_file(filename, file_params);
+  if (r != EXIT_SUCCESS || params.error_samples == 0)
+    return r;
+  // the measure loads both meshes and a search tree, more than the budget
+  if (params.memory_budget != 0) {
+    std::cerr << "error not measured within a memory budget" << std::endl;
+    return r;
+  }
+
+  // distances between the input and the result in both directions
+  std::cout << "\nMeasuring the error with " << params.error_samples << " samples..." << std::endl;
+  Mesh_error error;
+  if (!error.measure(filename, "out.off", params.error_samples))
+    return EXIT_FAILURE;
+  report_error(error);
 
   return EXIT_SUCCESS;
 }
 
-// The following is a Visitor that keeps track of the simplification process.
-// In this example the progress is printed real-time and a few statistics are
-// recorded (and printed in the end).
+void Surface_simplification::report_error(const Mesh_error &error)
+{
+  error.print(std::cout);
+  if (m_progress) {
+    std::ostringstream oss;
+    oss << "Hausdorff " << error.hausdorff() << " (" << error.hausdorff_ab
+      << " / " << error.hausdorff_ba << "), RMS " << error.rms_ab << " / " << error.rms_ba;
+    m_progress(oss.str());
+  }
+}
 
-int Surface_simplification::simplify(const std::string &filename)
+int Surface_simplification::simplify_file(
+  const std::string &filename,
+  const Params::Surface_simplification &params)
 {
+  // meshes larger than memory are streamed from the file
+  if (params.memory_budget != 0) {
+    Streaming_simplification streaming;
+    streaming.set_progress(m_progress);
+    return streaming.simplify(filename, "out.off", params);
+  }
+
+  // a linear time clustering removes the bulk of the faces first
+  Surface_mesh mesh;
+  if (params.cluster_resolution != 0) {
+    Vertex_clustering clustering;
+    const Params::Vertex_clustering cparams{params.cluster_resolution};
+    if (clustering.simplify(filename, cparams) != EXIT_SUCCESS)
+      return EXIT_FAILURE;
+    clustering.to_polygon_mesh(mesh);
+    return simplify(mesh, params);
+  }
+
   std::cout << "Opening file \"" << filename << "\"" << std::endl;
   std::ifstream ifs(filename);
   if (!ifs.is_open()) {
     std::cerr << "unable to open file" << std::endl;
     return EXIT_FAILURE;
   }
-
-  Surface_mesh_wid surface_mesh;
-  ifs >> surface_mesh;
-  if (!ifs) {
+  ifs >> mesh;
+  if (mesh.is_empty()) {
     std::cerr << "invalid OFF file" << std::endl;
     return EXIT_FAILURE;
   }
 
-  // The items in this polyhedron have an "id()" field 
-  // which the default index maps used in the algorithm
-  // need to get the index of a vertex/edge.
-  // However, the Polyhedron_3 class doesn't assign any value to
-  // this id(), so we must do it here:
-  int index = 0;
-
-  for (Surface_mesh_wid::Halfedge_iterator eb = surface_mesh.halfedges_begin()
-    , ee = surface_mesh.halfedges_end()
-    ; eb != ee
-    ; ++eb
-    )
-    eb->id() = index++;
-  index = 0;
-  for (Surface_mesh_wid::Vertex_iterator vb = surface_mesh.vertices_begin()
-    , ve = surface_mesh.vertices_end()
-    ; vb != ve
-    ; ++vb
-    )
-    vb->id() = index++;
-
-  // In this example, the simplification stops when the number of undirected edges
-  // drops below 10% of the initial count
-  SMS::Count_ratio_stop_predicate<Surface_mesh_wid> stop(0.1);
+  return simplify(mesh, params);
+}
+
+int Surface_simplification::simplify_serial(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params)
+{
+  // vertex indices are contiguous for the collapses and the progressive mesh
+  if (mesh.has_garbage())
+    mesh.collect_garbage();
+
+  std::cout << "\nStarting surface simplification...\n"
+    << mesh.number_of_faces() << " original faces, "
+    << mesh.number_of_edges() << " original undirected edges." << std::endl;
+  switch (params.stop) {
+    case Params::Surface_simplification::FACE_BUDGET:
+      std::cout << "Stop at " << params.nb_faces << " faces"; break;
+    case Params::Surface_simplification::EDGE_RATIO:
+      std::cout << "Stop at " << params.ratio << " of the edges"; break;
+    default:
+      std::cout << "Stop at error " << params.max_error; break;
+  }
+  std::cout << (params.lindstrom_turk ?
+    ", Lindstrom-Turk cost and placement" : ", edge length cost, midpoint placement")
+    << std::endl;
+
+  // input mesh indexed by the vertex indices, for the progressive mesh
+  std::vector<Point_3> points;
+  std::vector<Progressive_mesh::Triangle> triangles;
+  std::vector<Progressive_mesh::Collapse> collapses;
+  if (params.progressive) {
+    to_triangles(mesh, points, triangles);
+    collapses.reserve(mesh.number_of_vertices());
+  }
 
   Stats stats;
 
-  My_visitor vis(&stats);
-
-  // The index maps are not explicitly passed as in the previous
-  // example because the surface mesh items have a proper id() field.
-  // On the other hand, we pass here explicit cost and placement
-  // function which differ from the default policies, omitted in
-  // the previous example.
-  int r = SMS::edge_collapse
-  (surface_mesh
-    , stop
-    , CGAL::parameters::get_cost(SMS::Edge_length_cost<Surface_mesh_wid>())
-    .get_placement(SMS::Midpoint_placement<Surface_mesh_wid>())
-    .visitor(vis)
-  );
+  My_visitor vis(&stats, m_progress, m_console_progress);
+  if (params.progressive)
+    vis.collapses = &collapses;
+
+  const int r = collapse_edges(mesh, params, vis);
+  mesh.collect_garbage();
+  // the bounds are not the starting ones of the next run
+  remove_vertex_map<double>(mesh, "v:error");
 
   std::cout << "\nEdges collected: " << stats.collected
     << "\nEdges processed: " << stats.processed
     << "\nEdges collapsed: " << stats.collapsed
+    << "\nMaximum collapsed cost: " << stats.max_cost
     << std::endl
     << "\nEdges not collapsed due to topological constraints: " << stats.non_collapsable
     << "\nEdge not collapsed due to cost computation constraints: " << stats.cost_uncomputable
     << "\nEdge not collapsed due to placement computation constraints: " << stats.placement_uncomputable
+    << std::endl
+    << "\nCollecting time: " << stats.collect_time << " s"
+    << "\nProcessing time: " << stats.process_time << " s"
+    << "\nCollapsing time: " << stats.collapse_time << " s"
     << std::endl;
 
   std::cout << "\nFinished...\n" << r << " edges removed.\n"
-    << (surface_mesh.size_of_halfedges() / 2) << " final edges.\n";
+    << mesh.number_of_edges() << " final edges, "
+    << mesh.number_of_faces() << " final faces.\n";
+  if (m_progress) {
+    std::ostringstream oss;
+    oss << r << " edges removed, " << mesh.number_of_faces() << " faces left";
+    m_progress(oss.str());
+  }
 
   std::ofstream os("out.off");
-  os << surface_mesh;
+  os << mesh;
   os.flush();
   os.close();
 
-  if (m_pPolyhedron != nullptr)
-    delete m_pPolyhedron;
-  m_pPolyhedron = new Polyhedron;
+  if (params.progressive) {
+    if (m_progressive_mesh != nullptr)
+      delete m_progressive_mesh;
+    m_progressive_mesh = new Progressive_mesh;
+    if (m_progressive_mesh->build(points, triangles, collapses)) {
+      std::ofstream pos("out.pm", std::ios::binary);
+      m_progressive_mesh->write(pos);
+      std::cout << "Progressive mesh of " << m_progressive_mesh->nb_splits()
+        << " vertex splits written to out.pm" << std::endl;
+    }
+    else {
+      delete m_progressive_mesh;
+      m_progressive_mesh = nullptr;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int Surface_simplification::simplify_lods(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params)
+{
+  for (Surface_mesh *lod : m_lods)
+    delete lod;
+  m_lods.clear();
+
+  if (mesh.has_garbage())
+    mesh.collect_garbage();
+  const std::size_t nb_faces = mesh.number_of_faces();
+  std::cout << "\nBuilding " << params.nb_lods << " levels of detail from "
+    << nb_faces << " faces..." << std::endl;
 
-  // load out.off to m_pPolyhedron for visualization
-  std::ifstream is("out.off");
-  is >> *m_pPolyhedron;
-  is.close();
+  // each level continues the collapses of the previous one
+  Params::Surface_simplification level_params = params;
+  level_params.stop = Params::Surface_simplification::FACE_BUDGET;
+  level_params.nb_faces = nb_faces;
+  level_params.progressive = false;
+  for (unsigned int level = 0; level <= params.nb_lods; ++level) {
+    if (level != 0) {
+      level_params.nb_faces /= lod_face_ratio;
+      if (level_params.nb_faces == 0)
+        break;
+
+      Stats stats;
+      My_visitor vis(&stats, m_progress, m_console_progress);
+      collapse_edges(mesh, level_params, vis);
+      // indices are compacted for the next level
+      mesh.collect_garbage();
+      std::cout << "Level " << level << ": " << mesh.number_of_faces() << " faces, "
+        << stats.collect_time + stats.process_time + stats.collapse_time << " s" << std::endl;
+    }
+
+    m_lods.push_back(new Surface_mesh(mesh));
+  }
+
+  if (m_progress) {
+    std::ostringstream oss;
+    oss << m_lods.size() << " levels of detail, "
+      << m_lods.back()->number_of_faces() << " faces in the coarsest";
+    m_progress(oss.str());
+  }
+
+  // the coarsest level is the result
+  std::ofstream os("out.off");
+  os << mesh;
+  os.close();
 
   return EXIT_SUCCESS;
 }
 
+std::vector<Surface_mesh *> Surface_simplification::release_lods()
+{
+  std::vector<Surface_mesh *> lods;
+  lods.swap(m_lods);
+  return lods;
+}
+
+Progressive_mesh *Surface_simplification::release_progressive_mesh()
+{
+  Progressive_mesh *pm = m_progressive_mesh;
+  m_progressive_mesh = nullptr;
+  return pm;
+}
+
+int Surface_simplification::simplify_region(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params)
+{
+  if (params.lindstrom_turk)
+    return collapse_region_edges(mesh, params,
+      SMS::LindstromTurk_cost<Surface_mesh>(),
+      SMS::LindstromTurk_placement<Surface_mesh>());
+  return collapse_region_edges(mesh, params,
+    SMS::Edge_length_cost<Surface_mesh>(),
+    SMS::Midpoint_placement<Surface_mesh>());
+}
+
+int Surface_simplification::simplify_in_regions(
+  Surface_mesh &mesh,
+  const Params::Surface_simplification &params)
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+
+  const std::size_t nb_faces = mesh.number_of_faces();
+  const std::size_t nb_edges = mesh.number_of_edges();
+
+  Mesh_patches regions;
+  regions.build(mesh, params.region_faces);
+  std::cout << "\nSimplifying " << regions.size() << " regions of "
+    << nb_faces << " faces in parallel..." << std::endl;
+
+  // regions are simplified concurrently with their borders fixed
+  const std::size_t no_gid = std::numeric_limits<std::size_t>::max();
+  std::vector<Region_soup> soups(regions.size());
+  Algs::parallel_for(regions.size(), [&](const std::size_t i) {
+    Mesh_patches::Patch patch;
+    regions.extract(mesh, i, 0, patch);
+    Surface_mesh &rmesh = patch.mesh;
+
+    // region borders and vertices of the faces left out are fixed
+    Fixed_vertex_map fixed =
+      rmesh.add_property_map<vertex_descriptor, bool>("v:fixed", false).first;
+    Global_id_map gid =
+      rmesh.add_property_map<vertex_descriptor, std::size_t>("v:gid", no_gid).first;
+    std::unordered_set<std::size_t> failed_vertices;
+    for (const face_descriptor f : patch.failed_faces)
+      BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(halfedge(f, mesh), mesh))
+        failed_vertices.insert(std::size_t(v));
+    BOOST_FOREACH(const vertex_descriptor v, vertices(rmesh)) {
+      const std::size_t original = std::size_t(patch.to_mesh[std::size_t(v)]);
+      put(gid, v, original);
+      put(fixed, v, rmesh.is_border(v) || failed_vertices.count(original) != 0);
+    }
+
+    // share of the target, the ratio becomes a face budget
+    Params::Surface_simplification rparams = params;
+    const double share = double(regions.nb_faces(i)) / double(nb_faces);
+    if (params.stop == Params::Surface_simplification::FACE_BUDGET)
+      rparams.nb_faces = std::size_t(double(params.nb_faces) * share);
+    else if (params.stop == Params::Surface_simplification::EDGE_RATIO) {
+      rparams.stop = Params::Surface_simplification::FACE_BUDGET;
+      rparams.nb_faces = std::size_t(params.ratio * double(regions.nb_faces(i)));
+    }
+    simplify_region(rmesh, rparams);
+
+    // to soup, only fixed vertices keep a global id
+    Region_soup &soup = soups[i];
+    std::vector<std::size_t> to_soup(rmesh.num_vertices(), 0);
+    const Error_bound_map bounds = error_bounds(rmesh);
+    BOOST_FOREACH(const vertex_descriptor v, vertices(rmesh)) {
+      to_soup[std::size_t(v)] = soup.points.size();
+      soup.points.push_back(rmesh.point(v));
+      soup.gids.push_back(get(fixed, v) ? get(gid, v) : no_gid);
+      soup.bounds.push_back(get(bounds, v));
+    }
+    BOOST_FOREACH(const face_descriptor f, faces(rmesh))
+      BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(halfedge(f, rmesh), rmesh))
+        soup.triangles.push_back(to_soup[std::size_t(v)]);
+    soup.failed_faces.swap(patch.failed_faces);
+  });
+  const double region_time = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // merge the regions, fixed vertices are shared through their global id
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  std::vector<Point_3> points;
+  std::vector<double> bounds;
+  std::vector<std::size_t> triangles;
+  std::unordered_map<std::size_t, std::size_t> gid_index;
+  auto original_index = [&](const std::size_t g) {
+    const auto it = gid_index.find(g);
+    if (it != gid_index.end())
+      return it->second;
+    gid_index[g] = points.size();
+    points.push_back(get(vpm, vertex_descriptor(static_cast<Surface_mesh::size_type>(g))));
+    bounds.push_back(0.0);
+    return points.size() - 1;
+  };
+  std::size_t nb_failed_faces = 0;
+  for (Region_soup &soup : soups) {
+    std::vector<std::size_t> to_merged(soup.points.size(), 0);
+    for (std::size_t k = 0; k < soup.points.size(); ++k) {
+      if (soup.gids[k] != no_gid) {
+        // a shared vertex keeps the largest bound of its regions
+        to_merged[k] = original_index(soup.gids[k]);
+        bounds[to_merged[k]] = std::max(bounds[to_merged[k]], soup.bounds[k]);
+      }
+      else {
+        to_merged[k] = points.size();
+        points.push_back(soup.points[k]);
+        bounds.push_back(soup.bounds[k]);
+      }
+    }
+    for (const std::size_t k : soup.triangles)
+      triangles.push_back(to_merged[k]);
+    for (const face_descriptor f : soup.failed_faces)
+      BOOST_FOREACH(const vertex_descriptor v, vertices_around_face(halfedge(f, mesh), mesh))
+        triangles.push_back(original_index(std::size_t(v)));
+    nb_failed_faces += soup.failed_faces.size();
+    soup = Region_soup();
+  }
+  std::cout << "Regions simplified in " << region_time << " s, "
+    << triangles.size() / 3 << " faces, "
+    << nb_failed_faces << " non-manifold faces kept" << std::endl;
+
+  // the merged mesh replaces the input, the faces it rejects are dropped
+  mesh.clear();
+  mesh.reserve(Surface_mesh::size_type(points.size()),
+    Surface_mesh::size_type(triangles.size() / 2),
+    Surface_mesh::size_type(triangles.size() / 3));
+  std::vector<vertex_descriptor> merged_vertices;
+  merged_vertices.reserve(points.size());
+  for (const Point_3 &p : points)
+    merged_vertices.push_back(mesh.add_vertex(p));
+  // the seam pass continues the error bounds of the regions
+  if (params.stop == Params::Surface_simplification::MAX_ERROR) {
+    const Error_bound_map merged_bounds = error_bounds(mesh);
+    for (std::size_t k = 0; k < merged_vertices.size(); ++k)
+      put(merged_bounds, merged_vertices[k], bounds[k]);
+  }
+  std::size_t nb_dropped_faces = 0;
+  for (std::size_t k = 0; k < triangles.size(); k += 3)
+    if (mesh.add_face(merged_vertices[triangles[k]],
+      merged_vertices[triangles[k + 1]],
+      merged_vertices[triangles[k + 2]]) == Surface_mesh::null_face())
+      ++nb_dropped_faces;
+  if (nb_dropped_faces != 0)
+    std::cerr << nb_dropped_faces << " non-manifold faces dropped from the merged mesh" << std::endl;
+  std::vector<Point_3>().swap(points);
+  std::vector<double>().swap(bounds);
+  std::vector<std::size_t>().swap(triangles);
+  if (mesh.is_empty()) {
+    std::cerr << "failed to merge the regions" << std::endl;
+    remove_vertex_map<double>(mesh, "v:error");
+    remove_vertex_map<bool>(mesh, "v:fixed");
+    remove_vertex_map<std::size_t>(mesh, "v:gid");
+    return EXIT_FAILURE;
+  }
+
+  // serial pass over the whole mesh, collapses the seams to the global target
+  Params::Surface_simplification seam_params = params;
+  // progressive meshes are built from a full resolution mesh only
+  seam_params.progressive = false;
+  if (params.stop == Params::Surface_simplification::EDGE_RATIO) {
+    seam_params.stop = Params::Surface_simplification::FACE_BUDGET;
+    seam_params.nb_faces = std::size_t(params.ratio * double(nb_edges) * 2.0 / 3.0);
+  }
+  const int r = simplify_serial(mesh, seam_params);
+  // no vertex of a later run is fixed by the regions of this one
+  remove_vertex_map<bool>(mesh, "v:fixed");
+  remove_vertex_map<std::size_t>(mesh, "v:gid");
+  return r;
+}
+
 } // Algs
@@ -9,14 +9,19 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Progressive_mesh.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <functional>
 
-#include <CGAL/boost/graph/graph_traits_Polyhedron_3.h>
 // Simplification function
 #include <CGAL/Surface_mesh_simplification/edge_collapse.h>
 // Visitor base
 #include <CGAL/Surface_mesh_simplification/Edge_collapse_visitor_base.h>
-// Extended polyhedron items which include an id() field
-#include <CGAL/Polyhedron_items_with_id_3.h>
 // Stop-condition policy
 #include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Count_stop_predicate.h>
 #include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Count_ratio_stop_predicate.h>
@@ -24,14 +29,14 @@
 #include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Midpoint_placement.h>
 // Non-default cost and placement policies
 #include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Midpoint_and_length.h> 
+#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/LindstromTurk_cost.h>
+#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/LindstromTurk_placement.h>
 
 // include and typedef for surface simplification algorithm
-typedef CGAL::Polyhedron_3<Kernel, CGAL::Polyhedron_items_with_id_3> Surface_mesh_wid;
-typedef Surface_mesh_wid::Point_3 SmPoint;
-typedef Surface_mesh_wid::Halfedge_handle SmHalfedge_handle;
-typedef Surface_mesh_wid::Vertex_handle SmVertex_handle;
 namespace SMS = CGAL::Surface_mesh_simplification;
-typedef SMS::Edge_profile<Surface_mesh_wid> SmProfile;
+typedef SMS::Edge_profile<Surface_mesh> SmProfile;
+
+class Mesh_error;
 
 namespace Algs {
 
@@ -40,6 +45,12 @@ namespace Algs {
 /* http://doc.cgal.org/latest/Surface_mesh_simplification/              */
 /************************************************************************/
 class Surface_simplification {
+public:
+  // receives progress messages, called on the thread running the simplification,
+  // the GUI thread from the main window, the parallel regions never call it
+  typedef std::function<void(const std::string &)> Progress_callback;
+
+private:
   struct Stats {
     Stats()
       : collected(0)
@@ -48,6 +59,10 @@ class Surface_simplification {
       , non_collapsable(0)
       , cost_uncomputable(0)
       , placement_uncomputable(0)
+      , max_cost(0.0)
+      , collect_time(0.0)
+      , process_time(0.0)
+      , collapse_time(0.0)
     {}
 
     std::size_t collected;
@@ -56,15 +71,35 @@ class Surface_simplification {
     std::size_t non_collapsable;
     std::size_t cost_uncomputable;
     std::size_t placement_uncomputable;
+    // cost of the last collapsed edge, edges are collapsed by increasing cost
+    double max_cost;
+    // phase timings in seconds, processing excludes the collapses,
+    // the collapse time is extrapolated from one collapse every check_period
+    double collect_time;
+    double process_time;
+    double collapse_time;
   };
 
-  struct My_visitor : SMS::Edge_collapse_visitor_base<Surface_mesh_wid> {
-    My_visitor(Stats* s) : stats(s) {}
+  // Counts the events, progress is published at most once per interval
+  // and the clock is only read every check_period events.
+  struct My_visitor : SMS::Edge_collapse_visitor_base<Surface_mesh> {
+    typedef std::chrono::steady_clock Clock;
+
+    My_visitor(Stats* s, const Progress_callback &cb, const bool to_console)
+      : stats(s), progress(cb), console(to_console) {}
+
+    // Called before the collecting phase.
+    void OnStarted(Surface_mesh&)
+    {
+      phase_start = last_report = Clock::now();
+    }
+
     // Called during the collecting phase for each edge collected.
     void OnCollected(SmProfile const&, boost::optional<double> const&)
     {
       ++stats->collected;
-      std::cerr << "\rEdges collected: " << stats->collected << std::flush;
+      if (stats->collected % check_period == 0)
+        report("Edges collected", stats->collected, 0);
     }
 
     // Called during the processing phase for each edge selected.
@@ -75,23 +110,37 @@ class Surface_simplification {
       , std::size_t             current
     )
     {
+      if (stats->processed == 0) {
+        const Clock::time_point now = Clock::now();
+        stats->collect_time = seconds(now - phase_start);
+        phase_start = now;
+      }
+
       ++stats->processed;
       if (!cost)
         ++stats->cost_uncomputable;
+      else
+        last_cost = *cost;
 
-      if (current == initial)
-        std::cerr << "\n" << std::flush;
-      std::cerr << "\r" << current << std::flush;
+      if (stats->processed % check_period == 0)
+        report("Edges left", current, initial);
     }
 
     // Called during the processing phase for each edge being collapsed.
     // If placement is absent the edge is left uncollapsed.
-    void OnCollapsing(SmProfile const&
-      , boost::optional<SmPoint>  placement
+    void OnCollapsing(SmProfile const &profile
+      , boost::optional<Point_3>  placement
     )
     {
+      // the edge vertices are only valid before the collapse
+      collapsing[0] = std::size_t(profile.v0());
+      collapsing[1] = std::size_t(profile.v1());
       if (!placement)
         ++stats->placement_uncomputable;
+      else if (stats->collapsed % check_period == 0) {
+        is_timing = true;
+        collapse_start = Clock::now();
+      }
     }
 
     // Called for each edge which failed the so called link-condition,
@@ -103,26 +152,159 @@ class Surface_simplification {
     }
 
     // Called AFTER each edge has been collapsed
-    void OnCollapsed(SmProfile const&, SmVertex_handle)
+    void OnCollapsed(SmProfile const &profile, vertex_descriptor v)
     {
+      if (collapses) {
+        const std::size_t kept = std::size_t(v);
+        const std::size_t removed = collapsing[0] == kept ? collapsing[1] : collapsing[0];
+        collapses->push_back(Progressive_mesh::Collapse{
+          removed, kept, get(profile.vertex_point_map(), v)});
+      }
+
       ++stats->collapsed;
+      stats->max_cost = std::max(stats->max_cost, last_cost);
+      if (is_timing) {
+        sampled_time += seconds(Clock::now() - collapse_start);
+        ++nb_sampled;
+        is_timing = false;
+      }
+    }
+
+    // Called after the processing phase.
+    void OnFinished(Surface_mesh&)
+    {
+      const double elapsed = seconds(Clock::now() - phase_start);
+      if (nb_sampled != 0)
+        stats->collapse_time = sampled_time * double(stats->collapsed) / double(nb_sampled);
+      if (stats->processed == 0)
+        stats->collect_time = elapsed;
+      else
+        stats->process_time = std::max(0.0, elapsed - stats->collapse_time);
+      if (console)
+        std::cerr << std::endl;
+    }
+
+    void report(const char *label, const std::size_t count, const std::size_t total)
+    {
+      const Clock::time_point now = Clock::now();
+      if (now - last_report < interval)
+        return;
+      last_report = now;
+
+      std::ostringstream oss;
+      oss << label << ": " << count;
+      if (total != 0)
+        oss << " / " << total;
+      if (progress)
+        progress(oss.str());
+      if (console)
+        std::cerr << "\r" << oss.str() << std::flush;
+    }
+
+    static double seconds(const Clock::duration &d)
+    {
+      return std::chrono::duration<double>(d).count();
     }
 
+    static const std::size_t check_period = 4096;
+    const std::chrono::milliseconds interval = std::chrono::milliseconds(250);
+
     Stats* stats;
+    Progress_callback progress;
+    bool console;
+    // records the collapse sequence if set
+    std::vector<Progressive_mesh::Collapse> *collapses = nullptr;
+    double last_cost = 0.0;
+    // vertices of the edge being collapsed
+    std::size_t collapsing[2] = {0, 0};
+    Clock::time_point phase_start;
+    Clock::time_point last_report;
+    Clock::time_point collapse_start;
+    // sampled collapses
+    bool is_timing = false;
+    std::size_t nb_sampled = 0;
+    double sampled_time = 0.0;
   };
 
 public:
-  Surface_simplification() : m_pPolyhedron(nullptr) {}
+  Surface_simplification() :
+    m_progressive_mesh(nullptr), m_console_progress(true) {}
+
+  ~Surface_simplification() {
+    if (m_progressive_mesh)
+      delete m_progressive_mesh;
+    for (Surface_mesh *lod : m_lods)
+      delete lod;
+  }
+
+  /*!
+   * \brief Publish progress to the callback, and to the console if asked.
+   */
+  void set_progress(const Progress_callback &progress, const bool to_console) {
+    m_progress = progress;
+    m_console_progress = to_console;
+  }
+
+  /*!
+   * \brief Simplify the mesh in place and write it to out.off, in regions if
+   * region_faces is set, to a chain of levels of detail if nb_lods is set.
+   * The error of the result is reported if error_samples is set.
+   */
+  int simplify(Surface_mesh &mesh, const Params::Surface_simplification &params);
 
-  const Bbox_3 &bbox() { return m_bbox; }
+  /*!
+   * \brief Simplify an OFF file, after a vertex clustering if cluster_resolution is set,
+   * streamed to out.off within memory_budget if set.
+   * The error of out.off is reported if error_samples is set, except within
+   * a memory budget where the measure would not fit.
+   */
+  int simplify(const std::string &filename, const Params::Surface_simplification &params);
 
-  int simplify();
+  /*!
+   * \brief Simplify a region of a larger mesh in place, stops with FACE_BUDGET or MAX_ERROR.
+   * Vertices flagged in the "v:fixed" property map keep their positions and
+   * an edge between two of them is not collapsed, so the region borders are
+   * kept when they are fixed. The survivor of a collapse with a fixed vertex
+   * inherits its flag and its "v:gid" global id.
+   * Only touches the given mesh, safe to run concurrently on different regions.
+   * \return the number of removed edges
+   */
+  static int simplify_region(Surface_mesh &mesh, const Params::Surface_simplification &params);
 
-  int simplify(const std::string &filename);
+  /*!
+   * \brief Hand over the levels of detail, finest first, the caller owns them.
+   */
+  std::vector<Surface_mesh *> release_lods();
+
+  /*!
+   * \brief Hand over the recorded progressive mesh, null if none, the caller owns it.
+   */
+  Progressive_mesh *release_progressive_mesh();
+
+private:
+  // simplify an OFF file to out.off
+  int simplify_file(const std::string &filename, const Params::Surface_simplification &params);
+
+  // collapse edges of the whole mesh
+  int simplify_serial(Surface_mesh &mesh, const Params::Surface_simplification &params);
+
+  // chain of levels of detail, each continuing the collapses of the previous one
+  int simplify_lods(Surface_mesh &mesh, const Params::Surface_simplification &params);
+
+  // simplify spatial regions in parallel with their borders fixed, then the whole mesh serially
+  int simplify_in_regions(Surface_mesh &mesh, const Params::Surface_simplification &params);
+
+  // print the error and publish it to the progress
+  void report_error(const Mesh_error &error);
 
 private:
-  Bbox_3 m_bbox;
-  Polyhedron *m_pPolyhedron;
+  // levels of detail, from the input mesh to the coarsest
+  std::vector<Surface_mesh *> m_lods;
+  // collapse sequence of the last simplification, if recorded
+  Progressive_mesh *m_progressive_mesh;
+
+  Progress_callback m_progress;
+  bool m_console_progress;
 };
 
 }
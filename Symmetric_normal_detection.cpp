@@ -369,61 +369,82 @@ void Symmetric_normal_detection::detect(
   std::srand(static_cast<unsigned int>(std::time(nullptr)));
   for (std::size_t &c : m_shape_colors)
     c = static_cast<std::size_t>(std::rand() % 255);
+
+  build_buffers();
 }
 
-void Symmetric_normal_detection::draw()
+void Symmetric_normal_detection::build_buffers()
 {
-  if (m_points.empty())
-    return;
+  const Kernel2::Point_3 bbx_center(
+    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+  const Kernel2::Point_3 sphere_center(
+    bbx_center.x(),
+    bbx_center.y(),
+    m_bbox.zmin() - (m_bbox.zmax() - m_bbox.zmin()));
 
-  // draw point cloud with respect color
-  // ::glDisable(GL_LIGHTING);
-  ::glEnable(GL_LIGHTING);
-  ::glPointSize(2.0);
-  ::glBegin(GL_POINTS);
+  // normals are binned on a sphere under the bbox
+  Gaussian_sphere sphere;
+  sphere.reset();
+  m_point_buffer.clear(bbx_center.x(), bbx_center.y(), bbx_center.z());
+  m_point_buffer.reserve(m_points.size());
   for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
+    unsigned char rgb[3] = {192, 192, 192};
     if (m_point_shapes[pidx] >= 0) {
       const std::size_t cidx = m_shape_colors[m_point_shapes[pidx]];
-      ::glColor3ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
+      rgb[0] = Color_256::r(cidx);
+      rgb[1] = Color_256::g(cidx);
+      rgb[2] = Color_256::b(cidx);
     }
-    else
-      ::glColor3ub(192, 192, 192);
 
     const Kernel2::Vector_3 &n = m_points[pidx].get<1>();
-    ::glNormal3d(n.x(), n.y(), n.z());
-    const Kernel2::Point_3 &p = m_points[pidx].get<0>();
-    ::glVertex3d(p.x(), p.y(), p.z());
+    m_point_buffer.add_vertex(m_points[pidx].get<0>(), n, rgb[0], rgb[1], rgb[2]);
+    sphere.add(n, m_point_shapes[pidx]);
+  }
+  // the vote only finds candidates, a second pass counts them
+  for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx)
+    sphere.verify(m_points[pidx].get<1>(), m_point_shapes[pidx]);
+  m_point_octree.build(m_point_buffer);
+  sphere.to_buffer(m_normal_buffer,
+    sphere_center.x(), sphere_center.y(), sphere_center.z(), 1.0, m_shape_colors);
+
+  // z, y and x axis planes, as quads around the sphere center
+  const double len = 2.0;
+  const double quads[3][4][3] = {
+    {{len, len, 0}, {len, -len, 0}, {-len, -len, 0}, {-len, len, 0}},
+    {{len, 0, len}, {len, 0, -len}, {-len, 0, -len}, {-len, 0, len}},
+    {{0, len, len}, {0, len, -len}, {0, -len, -len}, {0, -len, len}}};
+  const unsigned char colors[3][3] = {{0, 0, 192}, {0, 192, 0}, {192, 0, 0}};
+  m_plane_buffer.clear(sphere_center.x(), sphere_center.y(), sphere_center.z());
+  m_plane_buffer.reserve(12, 18);
+  for (int i = 0; i < 3; ++i) {
+    const std::size_t first = m_plane_buffer.size();
+    for (int j = 0; j < 4; ++j)
+      m_plane_buffer.add_vertex(sphere_center + Kernel2::Vector_3(
+        quads[i][j][0], quads[i][j][1], quads[i][j][2]),
+        colors[i][0], colors[i][1], colors[i][2], 100);
+    m_plane_buffer.add_triangle_fan(first, 4);
   }
-  ::glEnd();
+}
 
-  const Kernel2::Point_3 sphere_center(
-    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
-    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
-    m_bbox.zmin() - (m_bbox.zmax() - m_bbox.zmin()));
+void Symmetric_normal_detection::draw(const Point_view &view)
+{
+  if (m_points.empty())
+    return;
 
-  // draw normals at bbox center
+  // draw point cloud with respect color
   // ::glDisable(GL_LIGHTING);
   ::glEnable(GL_LIGHTING);
-  ::glPointSize(1.0);
-  ::glBegin(GL_POINTS);
-  for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
-    if (m_point_shapes[pidx] >= 0) {
-      const std::size_t cidx = m_shape_colors[m_point_shapes[pidx]];
-      ::glColor3ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
-    }
-    else
-      ::glColor3ub(192, 192, 192);
+  ::glPointSize(2.0);
+  m_point_octree.draw(m_point_buffer, view, true);
 
-    const Kernel2::Vector_3 &n = m_points[pidx].get<1>();
-    ::glNormal3d(n.x(), n.y(), n.z());
-    const Kernel2::Vector_3 &p = m_points[pidx].get<1>();
-    ::glVertex3d(sphere_center.x() + p.x(), sphere_center.y() + p.y(), sphere_center.z() + p.z());
-  }
-  ::glEnd();
+  // draw normal density under the bbox
+  ::glEnable(GL_LIGHTING);
+  m_normal_buffer.draw(GL_TRIANGLES, true);
 
   // draw facade direction and z axis plane
   // test2, facade direction
-  const double len = 2.0;
   // const double angle = 81.0 / 180.0 * PI;
   // const double fd0[] = {std::cos(angle), std::sin(angle), 0};
   // const double fd1[] = {std::cos(angle + PI / 2.0), std::sin(angle + PI / 2.0), 0};
@@ -432,27 +453,7 @@ void Symmetric_normal_detection::draw()
   ::glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   ::glEnable(GL_BLEND);
   ::glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  ::glColor4ub(0, 0, 192, 100);
-  ::glBegin(GL_POLYGON);
-    ::glVertex3d(len + sphere_center.x(), len + sphere_center.y(), 0 + sphere_center.z());
-    ::glVertex3d(len + sphere_center.x(), -len + sphere_center.y(), 0 + sphere_center.z());
-    ::glVertex3d(-len + sphere_center.x(), -len + sphere_center.y(), 0 + sphere_center.z());
-    ::glVertex3d(-len + sphere_center.x(), len + sphere_center.y(), 0 + sphere_center.z());
-  ::glEnd();
-  ::glColor4ub(0, 192, 0, 100);
-  ::glBegin(GL_POLYGON);
-    ::glVertex3d(len + sphere_center.x(), 0 + sphere_center.y(), len + sphere_center.z());
-    ::glVertex3d(len + sphere_center.x(), 0 + sphere_center.y(), -len + sphere_center.z());
-    ::glVertex3d(-len + sphere_center.x(), 0 + sphere_center.y(), -len + sphere_center.z());
-    ::glVertex3d(-len + sphere_center.x(), 0 + sphere_center.y(), len + sphere_center.z());
-  ::glEnd();
-  ::glColor4ub(192, 0, 0, 100);
-  ::glBegin(GL_POLYGON);
-    ::glVertex3d(0 + sphere_center.x(), len + sphere_center.y(), len + sphere_center.z());
-    ::glVertex3d(0 + sphere_center.x(), len + sphere_center.y(), -len + sphere_center.z());
-    ::glVertex3d(0 + sphere_center.x(), -len + sphere_center.y(), -len + sphere_center.z());
-    ::glVertex3d(0 + sphere_center.x(), -len + sphere_center.y(), len + sphere_center.z());
-  ::glEnd();
+  m_plane_buffer.draw(GL_TRIANGLES);
 }
 
 } // Algs
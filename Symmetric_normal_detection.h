@@ -9,6 +9,9 @@
 
 #include "types.h"
 #include "parameters.h"
+#include "Render_buffer.h"
+#include "Point_octree.h"
+#include "Gaussian_sphere.h"
 
 #include <boost/tuple/tuple.hpp>
 
@@ -31,7 +34,11 @@ public:
 
   const Bbox_3 &bbox() { return m_bbox; }
 
-  void draw();
+  void draw(const Point_view &view);
+
+private:
+  // labeled points and normals to the render buffers, drawn without per point work
+  void build_buffers();
 
 private:
   Bbox_3 m_bbox;
@@ -42,6 +49,14 @@ private:
   std::vector<int> m_point_shapes;
   // shape color
   std::vector<std::size_t> m_shape_colors;
+  // points and normals colored by shape
+  Render_buffer m_point_buffer;
+  // level of detail over the reordered point buffer
+  Point_octree m_point_octree;
+  // normal density on a tessellated sphere
+  Render_buffer m_normal_buffer;
+  // axis planes through the normal sphere
+  Render_buffer m_plane_buffer;
 };
 
 } // namespace Algs
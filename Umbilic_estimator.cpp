@@ -0,0 +1,267 @@
+#include "Umbilic_estimator.h"
+#include "Parallel.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_set>
+
+#include <boost/foreach.hpp>
+#include <CGAL/boost/graph/iterator.h>
+
+void Umbilic_estimator::build(
+  const Surface_mesh &mesh,
+  const std::vector<double> &estimator,
+  const std::vector<Vector_3> &d1,
+  const std::vector<Vector_3> &d2,
+  const Ring_neighborhoods &neighborhoods)
+{
+  const std::size_t nb_vertices = mesh.number_of_vertices();
+  const double infinity = std::numeric_limits<double>::infinity();
+  m_estimator = estimator;
+  m_d1 = d1;
+  m_d2 = d2;
+  m_one_ring.assign(nb_vertices, 0.0);
+  m_smaller.assign(nb_vertices, infinity);
+  m_border.assign(nb_vertices, infinity);
+  m_coverage.assign(nb_vertices, 0.0);
+
+  // each vertex writes its own slots
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  Algs::parallel_for(nb_vertices, [&](const std::size_t i) {
+    const vertex_descriptor v(static_cast<Surface_mesh::size_type>(i));
+    const halfedge_descriptor h = halfedge(v, mesh);
+    if (h == boost::graph_traits<Surface_mesh>::null_halfedge()) {
+      // isolated vertex, never an umbilic
+      m_border[i] = 0.0;
+      return;
+    }
+
+    const Point_3 &p = get(vpm, v);
+    BOOST_FOREACH(const vertex_descriptor u, vertices_around_target(h, mesh))
+      m_one_ring[i] = std::max(m_one_ring[i],
+        std::sqrt(CGAL::squared_distance(p, get(vpm, u))));
+
+    const std::size_t nb_rings = neighborhoods.nb_rings(v);
+    measure(mesh, v, neighborhoods.neighbors(v),
+      neighborhoods.size(v, nb_rings),
+      nb_rings == 0 ? 0 : neighborhoods.size(v, nb_rings - 1),
+      false);
+  });
+}
+
+void Umbilic_estimator::classify(
+  const Surface_mesh &mesh,
+  const double size,
+  std::vector<vertex_descriptor> &umbilics)
+{
+  const std::size_t nb_vertices = m_estimator.size();
+  std::vector<char> is_umbilic(nb_vertices, 0);
+  Algs::parallel_for(nb_vertices, [&](const std::size_t i) {
+    if (m_smaller[i] < size || m_border[i] <= size)
+      return;
+    // the patch exceeds the gathered neighborhood
+    if (m_coverage[i] < size) {
+      refine(mesh, vertex_descriptor(static_cast<Surface_mesh::size_type>(i)), size);
+      if (m_smaller[i] < size || m_border[i] <= size)
+        return;
+    }
+    if (is_generic(mesh, vertex_descriptor(static_cast<Surface_mesh::size_type>(i)), size))
+      is_umbilic[i] = 1;
+  });
+
+  umbilics.clear();
+  for (std::size_t i = 0; i < nb_vertices; ++i)
+    if (is_umbilic[i])
+      umbilics.push_back(vertex_descriptor(static_cast<Surface_mesh::size_type>(i)));
+}
+
+void Umbilic_estimator::clear()
+{
+  std::vector<double>().swap(m_estimator);
+  std::vector<Vector_3>().swap(m_d1);
+  std::vector<Vector_3>().swap(m_d2);
+  std::vector<double>().swap(m_one_ring);
+  std::vector<double>().swap(m_smaller);
+  std::vector<double>().swap(m_border);
+  std::vector<double>().swap(m_coverage);
+}
+
+std::size_t Umbilic_estimator::bytes() const
+{
+  return (m_estimator.capacity() + m_one_ring.capacity() + m_smaller.capacity()
+    + m_border.capacity() + m_coverage.capacity()) * sizeof(double)
+    + (m_d1.capacity() + m_d2.capacity()) * sizeof(Vector_3);
+}
+
+void Umbilic_estimator::measure(
+  const Surface_mesh &mesh,
+  const vertex_descriptor v,
+  const vertex_descriptor *neighbors,
+  const std::size_t nb_neighbors,
+  const std::size_t last_ring,
+  const bool is_exhausted)
+{
+  const std::size_t i = std::size_t(v);
+  const double infinity = std::numeric_limits<double>::infinity();
+  const double unit = m_one_ring[i];
+  if (unit <= 0.0 || mesh.is_border(v)) {
+    m_border[i] = 0.0;
+    return;
+  }
+
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  const Point_3 &p = get(vpm, v);
+  double smaller = infinity;
+  double border = infinity;
+  double coverage = is_exhausted ? infinity : 0.0;
+  bool is_first = true;
+  for (std::size_t j = 1; j < nb_neighbors; ++j) {
+    const vertex_descriptor u = neighbors[j];
+    const double d = std::sqrt(CGAL::squared_distance(p, get(vpm, u))) / unit;
+    if (m_estimator[std::size_t(u)] < m_estimator[i])
+      smaller = std::min(smaller, d);
+    if (mesh.is_border(u))
+      border = std::min(border, d);
+    // the closest vertex of the last ring bounds the covered ball
+    if (!is_exhausted && j >= last_ring) {
+      coverage = is_first ? d : std::min(coverage, d);
+      is_first = false;
+    }
+  }
+
+  m_smaller[i] = smaller;
+  m_border[i] = border;
+  m_coverage[i] = coverage;
+}
+
+void Umbilic_estimator::refine(
+  const Surface_mesh &mesh,
+  const vertex_descriptor v,
+  const double size)
+{
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  const Point_3 &p = get(vpm, v);
+  const double radius = size * m_one_ring[std::size_t(v)];
+
+  std::unordered_set<std::size_t> visited;
+  visited.insert(std::size_t(v));
+  std::vector<vertex_descriptor> gathered(1, v);
+  std::size_t ring_begin = 0;
+  bool is_exhausted = false;
+  while (true) {
+    // stop once the last ring is out of the ball
+    const std::size_t ring_end = gathered.size();
+    double ring_distance = std::numeric_limits<double>::infinity();
+    for (std::size_t j = ring_begin; j < ring_end; ++j)
+      ring_distance = std::min(ring_distance,
+        std::sqrt(CGAL::squared_distance(p, get(vpm, gathered[j]))));
+    if (ring_distance >= radius)
+      break;
+
+    for (std::size_t j = ring_begin; j < ring_end; ++j)
+      BOOST_FOREACH(const vertex_descriptor u,
+        vertices_around_target(halfedge(gathered[j], mesh), mesh))
+        if (visited.insert(std::size_t(u)).second)
+          gathered.push_back(u);
+
+    if (gathered.size() == ring_end) {
+      is_exhausted = true;
+      break;
+    }
+    ring_begin = ring_end;
+  }
+
+  measure(mesh, v, gathered.data(), gathered.size(), ring_begin, is_exhausted);
+}
+
+bool Umbilic_estimator::is_generic(
+  const Surface_mesh &mesh,
+  const vertex_descriptor v,
+  const double size) const
+{
+  const auto vpm = get(CGAL::vertex_point, mesh);
+  const Point_3 &p = get(vpm, v);
+  const double squared_radius = CGAL::square(size * m_one_ring[std::size_t(v)]);
+  const auto is_in_ball = [&](const vertex_descriptor u) {
+    return CGAL::squared_distance(p, get(vpm, u)) <= squared_radius;
+  };
+
+  // the patch, faces with all their vertices in the ball, grown from the 1-ring of v
+  std::unordered_set<std::size_t> patch;
+  std::vector<face_descriptor> front;
+  BOOST_FOREACH(const face_descriptor f, faces_around_target(halfedge(v, mesh), mesh))
+    if (patch.insert(std::size_t(f)).second)
+      front.push_back(f);
+  const auto is_in_patch = [&](const face_descriptor f) {
+    return f != boost::graph_traits<Surface_mesh>::null_face()
+      && patch.count(std::size_t(f)) != 0;
+  };
+  halfedge_descriptor first_border = boost::graph_traits<Surface_mesh>::null_halfedge();
+  while (!front.empty()) {
+    const face_descriptor f = front.back();
+    front.pop_back();
+    BOOST_FOREACH(const halfedge_descriptor h, halfedges_around_face(halfedge(f, mesh), mesh)) {
+      const face_descriptor g = face(opposite(h, mesh), mesh);
+      if (g == boost::graph_traits<Surface_mesh>::null_face() || is_in_patch(g))
+        continue;
+      if (is_in_ball(target(next(opposite(h, mesh), mesh), mesh))) {
+        patch.insert(std::size_t(g));
+        front.push_back(g);
+      }
+    }
+  }
+
+  // border of the patch, only its first loop is walked
+  std::size_t nb_border = 0;
+  for (const std::size_t i : patch) {
+    const face_descriptor f(static_cast<Surface_mesh::size_type>(i));
+    BOOST_FOREACH(const halfedge_descriptor h, halfedges_around_face(halfedge(f, mesh), mesh))
+      if (!is_in_patch(face(opposite(h, mesh), mesh))) {
+        if (nb_border == 0)
+          first_border = h;
+        ++nb_border;
+      }
+  }
+  if (nb_border == 0)
+    return false;
+
+  // signed rotation of d1 projected on the tangent plane of v, d1 is a line field
+  Vector_3 normal = CGAL::cross_product(m_d1[std::size_t(v)], m_d2[std::size_t(v)]);
+  normal = normal / std::sqrt(normal * normal);
+  const auto tangent_d1 = [&](const vertex_descriptor u) {
+    Vector_3 d = m_d1[std::size_t(u)];
+    d = d - (d * normal) * normal;
+    const double n = std::sqrt(d * d);
+    return n > 0.0 ? d / n : d;
+  };
+  double angle = 0.0;
+  std::size_t nb_walked = 0;
+  halfedge_descriptor h = first_border;
+  Vector_3 dir = tangent_d1(source(h, mesh));
+  do {
+    Vector_3 dir_next = tangent_d1(target(h, mesh));
+    if (dir * dir_next < 0.0)
+      dir_next = -dir_next;
+    const double cosinus = std::max(-1.0, std::min(1.0, dir * dir_next));
+    const double np_angle = std::acos(cosinus);
+    angle += normal * CGAL::cross_product(dir, dir_next) < 0.0 ? -np_angle : np_angle;
+    dir = dir_next;
+
+    // next border halfedge around the target
+    halfedge_descriptor g = next(h, mesh);
+    while (is_in_patch(face(opposite(g, mesh), mesh)))
+      g = next(opposite(g, mesh), mesh);
+    h = g;
+  } while (h != first_border && ++nb_walked < nb_border);
+
+  // the patch is not a disk
+  if (nb_walked + 1 != nb_border)
+    return false;
+
+  // the line field turns by pi times twice its index around the umbilic, pi
+  // for an elliptic one, -pi for a hyperbolic one, 0 or 2 pi for the nearest
+  // non generic indices, the rotation is rounded to the closest multiple of pi
+  const double pi = 3.14159265358979323846;
+  return std::abs(std::abs(angle) - pi) < pi / 2.0;
+}
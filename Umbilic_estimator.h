@@ -0,0 +1,81 @@
+#ifndef UMBILIC_ESTIMATOR_H
+#define UMBILIC_ESTIMATOR_H
+
+#include "types.h"
+#include "Ring_neighborhoods.h"
+
+#include <vector>
+
+/*!
+ * \brief Umbilic detection with per vertex results independent of the umbilic size.
+ * A vertex is an umbilic if its estimator |k1 - k2| is minimal over its patch,
+ * the ball of radius size times its 1-ring size, and the patch does not reach
+ * the mesh border. For each vertex, the distances to the closest vertex with a
+ * smaller estimator and to the closest border vertex are cached, in 1-ring sizes,
+ * so classifying with another size is a threshold, only vertices whose patch
+ * exceeds the gathered neighborhood are refined.
+ * As in CGAL::Umbilic_approximation, a minimum is only kept if the index of the
+ * principal direction field around its patch is 1/2 or -1/2, non generic
+ * umbilics are discarded.
+ */
+class Umbilic_estimator {
+public:
+  Umbilic_estimator() {}
+
+  /*!
+   * \brief Measure every vertex on the given neighborhoods, in parallel.
+   * \param estimator |k1 - k2| of each vertex
+   * \param d1 maximal principal direction of each vertex
+   * \param d2 minimal principal direction of each vertex
+   */
+  void build(const Surface_mesh &mesh,
+    const std::vector<double> &estimator,
+    const std::vector<Vector_3> &d1,
+    const std::vector<Vector_3> &d2,
+    const Ring_neighborhoods &neighborhoods);
+
+  /*!
+   * \brief Collect the umbilics for the patch size, in vertex order.
+   * Undetermined vertices are refined on larger neighborhoods and cached.
+   */
+  void classify(const Surface_mesh &mesh,
+    const double size,
+    std::vector<vertex_descriptor> &umbilics);
+
+  bool empty() const { return m_estimator.empty(); }
+
+  void clear();
+
+  // memory held, in bytes
+  std::size_t bytes() const;
+
+private:
+  // measure v on the vertices ring by ring, v first, the last ring starting at last_ring
+  void measure(const Surface_mesh &mesh,
+    const vertex_descriptor v,
+    const vertex_descriptor *neighbors,
+    const std::size_t nb_neighbors,
+    const std::size_t last_ring,
+    const bool is_exhausted);
+
+  // gather rings around v until the ball of radius size is covered, and measure again
+  void refine(const Surface_mesh &mesh, const vertex_descriptor v, const double size);
+
+  // index of d1 along the border of the faces in the ball of radius size is +-1/2
+  bool is_generic(const Surface_mesh &mesh, const vertex_descriptor v, const double size) const;
+
+private:
+  std::vector<double> m_estimator;
+  // principal directions, the index is measured on d1 around d1 x d2
+  std::vector<Vector_3> m_d1;
+  std::vector<Vector_3> m_d2;
+  // maximal distance to the 1-ring vertices
+  std::vector<double> m_one_ring;
+  // in 1-ring sizes, infinite if none in the gathered neighborhood
+  std::vector<double> m_smaller;
+  std::vector<double> m_border;
+  // radius of the ball covered by the gathered neighborhood, in 1-ring sizes
+  std::vector<double> m_coverage;
+};
+
+#endif // UMBILIC_ESTIMATOR_H
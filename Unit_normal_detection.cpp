@@ -211,51 +211,55 @@ void Unit_normal_detection::detect(
   std::srand(static_cast<unsigned int>(std::time(nullptr)));
   for (std::size_t &c : m_shape_colors)
     c = static_cast<std::size_t>(std::rand() % 255);
+
+  build_buffers();
 }
 
-void Unit_normal_detection::draw()
+void Unit_normal_detection::build_buffers()
 {
-  if (m_points.empty())
-    return;
+  const Kernel2::Point_3 bbx_center(
+    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
+    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
+    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
 
-  // draw point cloud with respect color
-  ::glDisable(GL_LIGHTING);
-  ::glPointSize(5.0);
-  ::glBegin(GL_POINTS);
+  // normals are binned on a sphere at the bbox center
+  Gaussian_sphere sphere;
+  sphere.reset();
+  m_point_buffer.clear(bbx_center.x(), bbx_center.y(), bbx_center.z());
+  m_point_buffer.reserve(m_points.size());
   for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
+    unsigned char rgb[3] = {0, 0, 0};
     if (m_point_shapes[pidx] >= 0) {
       const std::size_t cidx = m_shape_colors[m_point_shapes[pidx]];
-      ::glColor3ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
+      rgb[0] = Color_256::r(cidx);
+      rgb[1] = Color_256::g(cidx);
+      rgb[2] = Color_256::b(cidx);
     }
-    else
-      ::glColor3ub(0, 0, 0);
 
-    const Kernel2::Point_3 &p = m_points[pidx].get<0>();
-    ::glVertex3d(p.x(), p.y(), p.z());
+    m_point_buffer.add_vertex(m_points[pidx].get<0>(), rgb[0], rgb[1], rgb[2]);
+    sphere.add(m_points[pidx].get<1>(), m_point_shapes[pidx]);
   }
-  ::glEnd();
+  // the vote only finds candidates, a second pass counts them
+  for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx)
+    sphere.verify(m_points[pidx].get<1>(), m_point_shapes[pidx]);
+  m_point_octree.build(m_point_buffer);
+  sphere.to_buffer(m_normal_buffer,
+    bbx_center.x(), bbx_center.y(), bbx_center.z(), 1.0, m_shape_colors);
+}
 
-  const Kernel2::Point_3 bbx_center(
-    (m_bbox.xmin() + m_bbox.xmax()) / 2.0,
-    (m_bbox.ymin() + m_bbox.ymax()) / 2.0,
-    (m_bbox.zmin() + m_bbox.zmax()) / 2.0);
+void Unit_normal_detection::draw(const Point_view &view)
+{
+  if (m_points.empty())
+    return;
 
-  // draw normals at bbox center
+  // draw point cloud with respect color
   ::glDisable(GL_LIGHTING);
   ::glPointSize(5.0);
-  ::glBegin(GL_POINTS);
-  for (std::size_t pidx = 0; pidx < m_points.size(); ++pidx) {
-    if (m_point_shapes[pidx] >= 0) {
-      const std::size_t cidx = m_shape_colors[m_point_shapes[pidx]];
-      ::glColor3ub(Color_256::r(cidx), Color_256::g(cidx), Color_256::b(cidx));
-    }
-    else
-      ::glColor3ub(0, 0, 0);
+  m_point_octree.draw(m_point_buffer, view);
 
-    const Kernel2::Vector_3 &n = m_points[pidx].get<1>();
-    ::glVertex3d(bbx_center.x() + n.x(), bbx_center.y() + n.y(), bbx_center.z() + n.z());
-  }
-  ::glEnd();
+  // draw normal density at bbox center
+  ::glEnable(GL_LIGHTING);
+  m_normal_buffer.draw(GL_TRIANGLES, true);
 }
 
 } // Algs
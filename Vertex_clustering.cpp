@@ -0,0 +1,329 @@
+#include "Vertex_clustering.h"
+#include "Off_reader.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
+
+#include <Eigen/Dense>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <gl/gl.h>
+
+// eigenvalues of the cell quadric below this ratio of the largest one are
+// truncated, the representative stays at the mean along their directions
+const double quadric_eigen_ratio = 1e-3;
+
+// A grid cell accumulates the quadrics of the faces incident to its vertices.
+struct Cluster_cell {
+  Cluster_cell(const std::uint64_t k) : key(k), count(0), index(no_index) {
+    std::fill(q, q + 10, 0.0);
+    std::fill(sum, sum + 3, 0.0);
+  }
+
+  // plane n.x + d = 0 weighted by w
+  void add_plane(const double *n, const double d, const double w) {
+    q[0] += w * n[0] * n[0]; q[1] += w * n[0] * n[1]; q[2] += w * n[0] * n[2];
+    q[3] += w * n[1] * n[1]; q[4] += w * n[1] * n[2]; q[5] += w * n[2] * n[2];
+    q[6] += w * d * n[0]; q[7] += w * d * n[1]; q[8] += w * d * n[2];
+    q[9] += w * d * d;
+  }
+
+  static const std::size_t no_index = std::numeric_limits<std::size_t>::max();
+
+  std::uint64_t key;
+  // symmetric A (6), b (3) and c of x^T A x + 2 b^T x + c
+  double q[10];
+  // vertex position sum and count, the mean is the fallback representative
+  double sum[3];
+  std::size_t count;
+  // index of the clustered vertex, if the cell is used by a face
+  std::size_t index;
+};
+
+namespace Algs {
+
+int Vertex_clustering::simplify(
+  const std::string &fname,
+  const Params::Vertex_clustering &params)
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+
+  m_points.clear();
+  m_triangles.clear();
+  m_normals.clear();
+  m_face_buffer.clear();
+  m_edge_buffer.clear();
+
+  std::cout << "Opening file \"" << fname << "\"" << std::endl;
+  Off_reader reader;
+  if (!reader.open(fname)) {
+    std::cerr << "invalid OFF file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::size_t nb_vertices = reader.nb_vertices();
+  const std::size_t nb_faces = reader.nb_faces();
+  if (nb_vertices > std::numeric_limits<std::uint32_t>::max()) {
+    std::cerr << "too many vertices" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the input vertices are the only per vertex data kept
+  std::vector<float> positions(nb_vertices * 3);
+  double bmin[3] = {0.0, 0.0, 0.0};
+  double bmax[3] = {0.0, 0.0, 0.0};
+  for (std::size_t i = 0; i < nb_vertices; ++i) {
+    double p[3];
+    if (!reader.read_vertex(p)) {
+      std::cerr << "invalid OFF file" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (std::size_t k = 0; k < 3; ++k) {
+      positions[i * 3 + k] = static_cast<float>(p[k]);
+      bmin[k] = i == 0 ? p[k] : std::min(bmin[k], p[k]);
+      bmax[k] = i == 0 ? p[k] : std::max(bmax[k], p[k]);
+    }
+  }
+
+  // cubic cells, resolution cells along the longest axis
+  const unsigned int resolution = std::max(1u, params.resolution);
+  const double extent = std::max(bmax[0] - bmin[0],
+    std::max(bmax[1] - bmin[1], bmax[2] - bmin[2]));
+  const double cell_size = extent > 0.0 ? extent / resolution : 1.0;
+  std::uint64_t dims[3];
+  for (std::size_t k = 0; k < 3; ++k)
+    dims[k] = std::max<std::uint64_t>(1,
+      static_cast<std::uint64_t>(std::ceil((bmax[k] - bmin[k]) / cell_size)));
+
+  // bin the vertices, cells are created on demand
+  std::vector<Cluster_cell> cells;
+  std::unordered_map<std::uint64_t, std::uint32_t> key_to_cell;
+  std::vector<std::uint32_t> vertex_cell(nb_vertices);
+  for (std::size_t i = 0; i < nb_vertices; ++i) {
+    std::uint64_t c[3];
+    for (std::size_t k = 0; k < 3; ++k)
+      c[k] = std::min(dims[k] - 1, static_cast<std::uint64_t>(
+        std::max(0.0, (positions[i * 3 + k] - bmin[k]) / cell_size)));
+    const std::uint64_t key = (c[0] * dims[1] + c[1]) * dims[2] + c[2];
+    const auto inserted = key_to_cell.insert(
+      std::make_pair(key, static_cast<std::uint32_t>(cells.size())));
+    if (inserted.second)
+      cells.push_back(Cluster_cell(key));
+    Cluster_cell &cell = cells[inserted.first->second];
+    for (std::size_t k = 0; k < 3; ++k)
+      cell.sum[k] += positions[i * 3 + k];
+    ++cell.count;
+    vertex_cell[i] = inserted.first->second;
+  }
+  std::unordered_map<std::uint64_t, std::uint32_t>().swap(key_to_cell);
+
+  // stream the faces, each triangle of the fan adds its plane to the cells
+  // of its vertices and survives if its vertices fall into 3 different cells
+  typedef std::array<std::uint32_t, 3> Cell_triangle;
+  std::unordered_set<Cell_triangle, boost::hash<Cell_triangle> > kept;
+  std::vector<Cell_triangle> triangles;
+  std::vector<std::size_t> face;
+  for (std::size_t f = 0; f < nb_faces; ++f) {
+    if (!reader.read_face(face)) {
+      std::cerr << "invalid OFF file" << std::endl;
+      return EXIT_FAILURE;
+    }
+    const std::size_t degree = face.size();
+
+    for (std::size_t j = 0; j < degree; ++j) {
+      if (face[j] >= nb_vertices) {
+        std::cerr << "invalid vertex index " << face[j] << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    for (std::size_t j = 1; j + 1 < degree; ++j) {
+      const std::size_t tri[3] = {face[0], face[j], face[j + 1]};
+      const float *p0 = &positions[tri[0] * 3];
+      const float *p1 = &positions[tri[1] * 3];
+      const float *p2 = &positions[tri[2] * 3];
+      const double u[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      const double v[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      double n[3] = {
+        u[1] * v[2] - u[2] * v[1],
+        u[2] * v[0] - u[0] * v[2],
+        u[0] * v[1] - u[1] * v[0]};
+      const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      const Cell_triangle ct = {vertex_cell[tri[0]], vertex_cell[tri[1]], vertex_cell[tri[2]]};
+      if (len > 0.0) {
+        for (std::size_t k = 0; k < 3; ++k)
+          n[k] /= len;
+        const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        // area weighted, the same cell is only counted once
+        for (std::size_t k = 0; k < 3; ++k)
+          if ((k == 0 || ct[k] != ct[0]) && (k != 2 || ct[2] != ct[1]))
+            cells[ct[k]].add_plane(n, d, len / 2.0);
+      }
+
+      if (ct[0] == ct[1] || ct[1] == ct[2] || ct[2] == ct[0])
+        continue;
+      // the first orientation met is kept for duplicates
+      Cell_triangle sorted = ct;
+      std::sort(sorted.begin(), sorted.end());
+      if (kept.insert(sorted).second)
+        triangles.push_back(ct);
+    }
+  }
+  reader.close();
+  std::vector<float>().swap(positions);
+  std::vector<std::uint32_t>().swap(vertex_cell);
+  std::unordered_set<Cell_triangle, boost::hash<Cell_triangle> >().swap(kept);
+
+  // one vertex per cell used by a face, at the minimum of its quadric
+  // within the cell, at the mean of its vertices otherwise
+  for (Cell_triangle &t : triangles) {
+    for (std::size_t k = 0; k < 3; ++k) {
+      Cluster_cell &cell = cells[t[k]];
+      if (cell.index != Cluster_cell::no_index)
+        continue;
+      cell.index = m_points.size();
+
+      const Eigen::Vector3d mean(cell.sum[0] / cell.count,
+        cell.sum[1] / cell.count, cell.sum[2] / cell.count);
+      Eigen::Matrix3d A;
+      A << cell.q[0], cell.q[1], cell.q[2],
+        cell.q[1], cell.q[3], cell.q[4],
+        cell.q[2], cell.q[4], cell.q[5];
+      const Eigen::Vector3d b(cell.q[6], cell.q[7], cell.q[8]);
+
+      Eigen::Vector3d x = mean;
+      const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(A);
+      const Eigen::Vector3d &lambda = solver.eigenvalues();
+      const double lambda_max = lambda.maxCoeff();
+      if (solver.info() == Eigen::Success && lambda_max > 0.0) {
+        // truncated pseudo inverse around the mean
+        const Eigen::Vector3d r = -(A * mean + b);
+        for (int e = 0; e < 3; ++e) {
+          if (lambda[e] <= quadric_eigen_ratio * lambda_max)
+            continue;
+          const Eigen::Vector3d ev = solver.eigenvectors().col(e);
+          x += ev * (ev.dot(r) / lambda[e]);
+        }
+
+        // stay within the cell, with half a cell of slack
+        const std::uint64_t c[3] = {
+          cell.key / (dims[1] * dims[2]),
+          (cell.key / dims[2]) % dims[1],
+          cell.key % dims[2]};
+        for (int k = 0; k < 3; ++k) {
+          const double lo = bmin[k] + (c[k] - 0.5) * cell_size;
+          const double hi = bmin[k] + (c[k] + 1.5) * cell_size;
+          if (!(x[k] >= lo && x[k] <= hi)) {
+            x = mean;
+            break;
+          }
+        }
+      }
+      m_points.push_back(Point_3(x[0], x[1], x[2]));
+    }
+  }
+
+  m_triangles.reserve(triangles.size());
+  m_normals.reserve(triangles.size());
+  for (const Cell_triangle &t : triangles) {
+    const std::array<std::size_t, 3> tri = {
+      cells[t[0]].index, cells[t[1]].index, cells[t[2]].index};
+    m_triangles.push_back(tri);
+    Vector_3 n = CGAL::normal(m_points[tri[0]], m_points[tri[1]], m_points[tri[2]]);
+    const double len = std::sqrt(n.squared_length());
+    m_normals.push_back(len > 0.0 ? n / len : n);
+  }
+
+  if (!m_points.empty())
+    m_bbox = CGAL::bbox_3(m_points.begin(), m_points.end());
+
+  const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "#cells " << cells.size() << std::endl;
+  std::cout << "#vertices " << nb_vertices << " -> " << m_points.size() << std::endl;
+  std::cout << "#faces " << nb_faces << " -> " << m_triangles.size() << std::endl;
+  std::cout << "#time " << elapsed << "s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+bool Vertex_clustering::write_off(const std::string &fname) const
+{
+  std::ofstream ofs(fname);
+  if (!ofs.is_open()) {
+    std::cerr << "unable to write file " << fname << std::endl;
+    return false;
+  }
+
+  ofs.precision(17);
+  ofs << "OFF\n" << m_points.size() << ' ' << m_triangles.size() << " 0\n";
+  for (const Point_3 &p : m_points)
+    ofs << p.x() << ' ' << p.y() << ' ' << p.z() << '\n';
+  for (const std::array<std::size_t, 3> &t : m_triangles)
+    ofs << "3 " << t[0] << ' ' << t[1] << ' ' << t[2] << '\n';
+
+  return bool(ofs);
+}
+
+void Vertex_clustering::build_buffers()
+{
+  const double cx = (m_bbox.xmin() + m_bbox.xmax()) / 2.0;
+  const double cy = (m_bbox.ymin() + m_bbox.ymax()) / 2.0;
+  const double cz = (m_bbox.zmin() + m_bbox.zmax()) / 2.0;
+
+  // shuffled so that any prefix of the faces is spread over the mesh
+  std::vector<std::size_t> order(m_triangles.size());
+  for (std::size_t fidx = 0; fidx < order.size(); ++fidx)
+    order[fidx] = fidx;
+  std::shuffle(order.begin(), order.end(), std::mt19937(0u));
+
+  // face normals need a vertex per corner
+  m_face_buffer.clear(cx, cy, cz);
+  m_face_buffer.reserve(3 * m_triangles.size());
+  for (const std::size_t fidx : order)
+    for (const std::size_t vidx : m_triangles[fidx])
+      m_face_buffer.add_vertex(m_points[vidx], m_normals[fidx], 192, 192, 192);
+
+  m_edge_buffer.clear(cx, cy, cz);
+  m_edge_buffer.reserve(m_points.size(), 6 * m_triangles.size());
+  for (const Point_3 &p : m_points)
+    m_edge_buffer.add_vertex(p, 0, 0, 0);
+  for (const std::size_t fidx : order) {
+    const std::array<std::size_t, 3> &t = m_triangles[fidx];
+    for (std::size_t k = 0; k < 3; ++k) {
+      m_edge_buffer.add_index(std::uint32_t(t[k]));
+      m_edge_buffer.add_index(std::uint32_t(t[(k + 1) % 3]));
+    }
+  }
+}
+
+void Vertex_clustering::draw(const std::size_t max_faces)
+{
+  if (m_triangles.empty())
+    return;
+  if (m_face_buffer.empty())
+    build_buffers();
+
+  // draw lit faces
+  ::glEnable(GL_LIGHTING);
+  m_face_buffer.draw_prefix(GL_TRIANGLES, max_faces, true);
+
+  // draw black edges, three per face
+  ::glDisable(GL_LIGHTING);
+  ::glLineWidth(1.0f);
+  m_edge_buffer.draw_prefix(GL_LINES, 3 * max_faces);
+}
+
+} // Algs
@@ -0,0 +1,84 @@
+#ifndef VERTEX_CLUSTERING_H
+#define VERTEX_CLUSTERING_H
+
+#include "types.h"
+#include "parameters.h"
+#include "Render_buffer.h"
+
+#include <array>
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+#include <CGAL/Polygon_mesh_processing/orient_polygon_soup.h>
+#include <CGAL/Polygon_mesh_processing/polygon_soup_to_polygon_mesh.h>
+
+namespace Algs {
+
+/************************************************************************/
+/* Vertex Clustering Simplification                                     */
+/* Rossignac - Borrel uniform grid, Lindstrom quadric representatives   */
+/* Linear time, for previews and as a first stage of the edge collapse  */
+/************************************************************************/
+class Vertex_clustering {
+public:
+  Vertex_clustering() {}
+
+  /*!
+   * \brief Cluster the vertices of an OFF file on a uniform grid.
+   * Only the input vertex positions are kept in memory, the faces are
+   * streamed from the file and merged into their cells' quadrics.
+   * \return EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int simplify(const std::string &fname, const Params::Vertex_clustering &params);
+
+  /*!
+   * \brief Write the clustered mesh, faces may be non-manifold.
+   */
+  bool write_off(const std::string &fname) const;
+
+  /*!
+   * \brief Convert the clustered mesh, non-manifold vertices and edges are
+   * duplicated so that the result is a valid polygon mesh.
+   */
+  template <typename PolygonMesh>
+  void to_polygon_mesh(PolygonMesh &pm) const {
+    std::vector<Point_3> points(m_points);
+    std::vector<std::vector<std::size_t> > polygons(m_triangles.size(), std::vector<std::size_t>(3));
+    for (std::size_t i = 0; i < m_triangles.size(); ++i)
+      for (std::size_t j = 0; j < 3; ++j)
+        polygons[i][j] = m_triangles[i][j];
+    CGAL::Polygon_mesh_processing::orient_polygon_soup(points, polygons);
+    CGAL::Polygon_mesh_processing::polygon_soup_to_polygon_mesh(points, polygons, pm);
+  }
+
+  std::size_t nb_vertices() const { return m_points.size(); }
+
+  std::size_t nb_faces() const { return m_triangles.size(); }
+
+  const Bbox_3 &bbox() { return m_bbox; }
+
+  // at most max_faces faces and their edges, 0 for no limit
+  void draw(const std::size_t max_faces);
+
+private:
+  // faces and edges to the render buffers, at the first draw of a result
+  void build_buffers();
+
+private:
+  Bbox_3 m_bbox;
+
+  // clustered mesh, one vertex per occupied cell
+  std::vector<Point_3> m_points;
+  std::vector<std::array<std::size_t, 3> > m_triangles;
+
+  // rendering data, face normals
+  std::vector<Vector_3> m_normals;
+  // flat shaded faces, and the edges over the shared vertices
+  Render_buffer m_face_buffer;
+  Render_buffer m_edge_buffer;
+};
+
+} // namespace Algs
+
+#endif // VERTEX_CLUSTERING_H
@@ -1,6 +1,21 @@
 #include "Viewer.h"
 #include "Scene.h"
 
+#include <QElapsedTimer>
+
+#include <cmath>
+#include <algorithm>
+
+// points drawn per cloud and frame
+const std::size_t point_budget = 4000000;
+// points, and primitives per buffer, drawn while the camera moves,
+// scaled to the frame time target
+const std::size_t interaction_point_budget = 500000;
+const std::size_t interaction_primitive_budget = 200000;
+const double interaction_frame_ms = 1000.0 / 30.0;
+// frames in the frame time history of the statistics overlay
+const std::size_t nb_frame_times = 240;
+
 QString Viewer::helpString() const
 {
   QString text("<h1>CGAL Algorithm Demo</h1>");
@@ -51,11 +66,119 @@ QString Viewer::helpString() const
 
 void Viewer::draw()
 {
+  draw_scene(point_budget, 0);
+}
+
+void Viewer::fastDraw()
+{
+  // the budgets of the next frame follow the rendering time of this one,
+  // the time between frames also counts the input events
+  const double ms = draw_scene(
+    std::size_t(double(interaction_point_budget) * m_interaction_scale),
+    std::max(std::size_t(1), std::size_t(double(interaction_primitive_budget) * m_interaction_scale)));
+  if (ms > 0.0)
+    m_interaction_scale = std::max(1.0 / 64.0, std::min(4.0,
+      m_interaction_scale * std::max(0.5, std::min(2.0, interaction_frame_ms / ms))));
+}
+
+void Viewer::toggle_statistics()
+{
+  m_is_statistics_shown = !m_is_statistics_shown;
+  m_frame_times.clear();
+  if (m_pScene != nullptr)
+    m_pScene->set_draw_timing(m_is_statistics_shown);
+}
+
+double Viewer::draw_scene(const std::size_t max_points, const std::size_t max_primitives)
+{
+  QElapsedTimer frame_timer;
+  frame_timer.start();
   QGLViewer::draw();
   if(m_pScene != nullptr) {
     ::glClearColor(1.0f,1.0f,1.0f,0.0f);
+    // level of detail from the projected scene diameter
+    const double ratio = camera()->pixelGLRatio(sceneCenter());
+    if (ratio > 0.0)
+      m_pScene->select_lod(2.0 * sceneRadius() / ratio);
+
+    // frustum and pixel size for the point clouds level of detail
+    Point_view view;
+    camera()->getFrustumPlanesCoefficients(view.planes);
+    const qglviewer::Vec eye = camera()->position();
+    const qglviewer::Vec direction = camera()->viewDirection();
+    for (int k = 0; k < 3; ++k) {
+      view.eye[k] = eye[k];
+      view.view_direction[k] = direction[k];
+    }
+    view.is_perspective = camera()->type() == qglviewer::Camera::PERSPECTIVE;
+    view.pixel_size = view.is_perspective ?
+      2.0 * std::tan(camera()->fieldOfView() / 2.0) / camera()->screenHeight() : ratio;
+    view.point_budget = std::max(std::size_t(1), max_points);
+    m_pScene->set_point_view(view);
+    m_pScene->set_primitive_budget(max_primitives);
     m_pScene->draw();
   }
+
+  // the rendering is waited for, only when the time is used
+  const bool is_timed = max_primitives != 0 || m_is_statistics_shown;
+  if (is_timed)
+    ::glFinish();
+  const double ms = double(frame_timer.nsecsElapsed()) / 1.0e6;
+  if (m_is_statistics_shown) {
+    m_frame_times.push_back(ms);
+    if (m_frame_times.size() > nb_frame_times)
+      m_frame_times.pop_front();
+    draw_statistics();
+  }
+
+  return is_timed ? ms : 0.0;
+}
+
+void Viewer::draw_statistics()
+{
+  double sum = 0.0;
+  double worst = 0.0;
+  for (const double ms : m_frame_times) {
+    sum += ms;
+    worst = std::max(worst, ms);
+  }
+
+  ::glDisable(GL_LIGHTING);
+  ::glColor3ub(0, 0, 0);
+  int y = 20;
+  drawText(10, y, QString("Frame %1 ms, mean %2 ms, max %3 ms over %4 frames")
+    .arg(m_frame_times.back(), 0, 'f', 2)
+    .arg(sum / double(m_frame_times.size()), 0, 'f', 2)
+    .arg(worst, 0, 'f', 2)
+    .arg(m_frame_times.size()));
+  if (m_pScene != nullptr) {
+    for (const Scene::Draw_stats &s : m_pScene->draw_stats()) {
+      y += 16;
+      drawText(10, y, QString("%1: %2 ms, %3 draws, %4 primitives, %5 KB uploaded")
+        .arg(QString::fromStdString(s.name))
+        .arg(s.ms, 0, 'f', 2)
+        .arg(s.work.nb_draws)
+        .arg(s.work.nb_primitives)
+        .arg(s.work.upload_bytes / 1024));
+    }
+  }
+
+  // frame time history, a pixel per frame and per ms over the interaction target
+  startScreenCoordinatesSystem();
+  const double x0 = 10.0;
+  const double y0 = double(height()) - 10.0;
+  ::glLineWidth(1.0f);
+  ::glColor3ub(192, 192, 192);
+  ::glBegin(GL_LINES);
+  ::glVertex2d(x0, y0 - interaction_frame_ms);
+  ::glVertex2d(x0 + double(nb_frame_times), y0 - interaction_frame_ms);
+  ::glEnd();
+  ::glColor3ub(255, 0, 0);
+  ::glBegin(GL_LINE_STRIP);
+  for (std::size_t i = 0; i < m_frame_times.size(); ++i)
+    ::glVertex2d(x0 + double(i), y0 - m_frame_times[i]);
+  ::glEnd();
+  stopScreenCoordinatesSystem();
 }
 
 void Viewer::initializeGL()
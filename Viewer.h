@@ -3,6 +3,8 @@
 
 #include <QGLViewer/qglviewer.h>
 
+#include <deque>
+
 // forward declarations
 class QWidget;
 class Scene;
@@ -12,22 +14,48 @@ class Viewer : public QGLViewer
   Q_OBJECT
 
 public:
-  Viewer(QWidget *parent) : QGLViewer(parent), m_pScene(nullptr) {}
+  Viewer(QWidget *parent) :
+    QGLViewer(parent),
+    m_pScene(nullptr),
+    m_interaction_scale(1.0),
+    m_is_statistics_shown(false) {}
 
   // overload several QGLViewer virtual functions
   void draw();
 
+  // while the camera is manipulated, within budgets adapted to the frame time
+  void fastDraw();
+
   void initializeGL();
 
   void setScene(Scene *pScene) {
     m_pScene = pScene;
   }
 
+  // frame time and draw statistics overlay
+  void toggle_statistics();
+
   // customize help message
   QString helpString() const;
 
+private:
+  // draw the scene with at most max_points points per cloud and max_primitives
+  // primitives per buffer, 0 primitives for no limit
+  // \return the rendering time in ms, 0 if not waited for
+  double draw_scene(const std::size_t max_points, const std::size_t max_primitives);
+
+  // frame time, its history and the draw statistics of the scene
+  void draw_statistics();
+
 private:
   Scene* m_pScene;
+
+  // scale of the interaction budgets, from the rendering time of the last interaction frame
+  double m_interaction_scale;
+
+  // overlay, with the frame times of the last frames, latest last
+  bool m_is_statistics_shown;
+  std::deque<double> m_frame_times;
 }; // end class Viewer
 
 #endif // VIEWER_H
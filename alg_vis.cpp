@@ -6,11 +6,254 @@
 ////////////////////////////////////////////////////
 
 #include "Mainwindow.h"
+#include "Surface_simplification.h"
+#include "Scene.h"
+#include "Settings_dialog.h"
+#include "Snapshot_renderer.h"
 #include <QApplication>
 #include <CGAL/Qt/resources.h>
 
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <algorithm>
+
+/*!
+ * \brief Batch surface simplification to out.off without the GUI:
+ * alg_vis --simplify in.off [--faces N] [--edge-ratio R] [--max-error E]
+ *   [--lindstrom-turk] [--regions N] [--cluster N] [--memory MB] [--error-samples N]
+ */
+static int batch_simplify(int argc, char **argv)
+{
+  std::string fname;
+  Params::Surface_simplification params = {
+    Params::Surface_simplification::FACE_BUDGET, 1000, 0.5, 0.0, false,
+    0, 0, 0, false, 0, 100000};
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--simplify") && has_value)
+      fname = argv[++i];
+    else if (!std::strcmp(argv[i], "--faces") && has_value) {
+      params.stop = Params::Surface_simplification::FACE_BUDGET;
+      params.nb_faces = std::strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!std::strcmp(argv[i], "--edge-ratio") && has_value) {
+      params.stop = Params::Surface_simplification::EDGE_RATIO;
+      params.ratio = std::atof(argv[++i]);
+    }
+    else if (!std::strcmp(argv[i], "--max-error") && has_value) {
+      params.stop = Params::Surface_simplification::MAX_ERROR;
+      params.max_error = std::atof(argv[++i]);
+    }
+    else if (!std::strcmp(argv[i], "--lindstrom-turk"))
+      params.lindstrom_turk = true;
+    else if (!std::strcmp(argv[i], "--regions") && has_value)
+      params.region_faces = std::strtoul(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--cluster") && has_value)
+      params.cluster_resolution = std::strtoul(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--memory") && has_value)
+      params.memory_budget = std::strtoul(argv[++i], nullptr, 10);
+    else if (!std::strcmp(argv[i], "--error-samples") && has_value)
+      params.error_samples = std::strtoul(argv[++i], nullptr, 10);
+    else {
+      std::cerr << "unknown option " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Algs::Surface_simplification alg;
+  return alg.simplify(fname, params);
+}
+
+/*!
+ * \brief Batch snapshots of an algorithm result on each file, without a display:
+ * alg_vis --snapshot ALGORITHM --output DIR [--width W] [--height H] [--jobs N] files...
+ * ALGORITHM is mesh, shape, hplane, unormal, snormal, ridge or pridge, run with
+ * the parameters of the settings dialog. The algorithms run on jobs files at a
+ * time in parallel, one by default as each holds its whole scene in memory,
+ * then their scenes are rendered in turn with software OpenGL to
+ * DIR/<file base name>.png. A file that fails is reported and skipped.
+ */
+static int batch_snapshot(int argc, char **argv)
+{
+  // no GPU nor display needed, set before the application is created
+#ifndef ALG_VIS_EGL
+  QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+#endif
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  if (qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE"))
+    qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+  QApplication app(argc, argv);
+
+  std::string algorithm;
+  std::string output(".");
+  int width = 512;
+  int height = 512;
+  std::size_t nb_jobs = 1;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--snapshot") && has_value)
+      algorithm = argv[++i];
+    else if (!std::strcmp(argv[i], "--output") && has_value)
+      output = argv[++i];
+    else if (!std::strcmp(argv[i], "--width") && has_value)
+      width = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--height") && has_value)
+      height = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--jobs") && has_value)
+      nb_jobs = std::max(std::size_t(1), std::size_t(std::strtoul(argv[++i], nullptr, 10)));
+    else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      std::cerr << "unknown option " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+    else
+      files.push_back(argv[i]);
+  }
+  if (width <= 0 || height <= 0) {
+    std::cerr << "invalid snapshot size " << width << "x" << height << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // parameters from the settings dialog, read once on the GUI thread
+  const Settings_dialog dial;
+  std::function<int(Scene &, const std::string &)> run;
+  if (algorithm == "mesh")
+    run = [](Scene &scene, const std::string &fname) {
+      return scene.open(fname);
+    };
+  else if (algorithm == "shape") {
+    const Params::Shape_detection params{
+      dial.shape_detection_probability->value(),
+      static_cast<std::size_t>(dial.shape_detection_min_points->value()),
+      dial.shape_detection_epsilon->value(),
+      dial.shape_detection_cluster_epsilon->value(),
+      dial.shape_detection_normal_threshold->value()};
+    run = [params](Scene &scene, const std::string &fname) {
+      return scene.shape_detection(fname, params);
+    };
+  }
+  else if (algorithm == "hplane") {
+    const Params::Shape_detection params{
+      dial.hplane_detection_probability->value(),
+      static_cast<std::size_t>(dial.hplane_detection_min_points->value()),
+      dial.hplane_detection_epsilon->value(),
+      dial.hplane_detection_cluster_epsilon->value(),
+      dial.hplane_detection_normal_threshold->value()};
+    run = [params](Scene &scene, const std::string &fname) {
+      return scene.horizontal_plane_detection(fname, params);
+    };
+  }
+  else if (algorithm == "unormal") {
+    const Params::Shape_detection params{
+      dial.unormal_detection_probability->value(),
+      static_cast<std::size_t>(dial.unormal_detection_min_points->value()),
+      dial.unormal_detection_epsilon->value(),
+      dial.unormal_detection_cluster_epsilon->value(),
+      dial.unormal_detection_normal_threshold->value()};
+    run = [params](Scene &scene, const std::string &fname) {
+      return scene.unit_normal_detection(fname, params);
+    };
+  }
+  else if (algorithm == "snormal") {
+    const Params::Shape_detection params{
+      dial.snormal_detection_probability->value(),
+      static_cast<std::size_t>(dial.snormal_detection_min_points->value()),
+      dial.snormal_detection_epsilon->value(),
+      dial.snormal_detection_cluster_epsilon->value(),
+      dial.snormal_detection_normal_threshold->value()};
+    const bool is_constrained = dial.snormal_detection_is_constrained->isChecked();
+    run = [params, is_constrained](Scene &scene, const std::string &fname) {
+      return scene.symmetric_normal_detection(fname, params, is_constrained);
+    };
+  }
+  else if (algorithm == "ridge") {
+    const Params::Ridge_detection params{
+      static_cast<unsigned int>(dial.ridge_detection_nb_rings->value()),
+      static_cast<unsigned int>(dial.ridge_detection_nb_points->value()),
+      static_cast<unsigned int>(dial.ridge_detection_nb_scales->value()),
+      dial.ridge_detection_umb_size->value(),
+      static_cast<unsigned int>(dial.ridge_detection_patch_size->value())};
+    run = [params](Scene &scene, const std::string &fname) {
+      return scene.ridge_detection(fname, params);
+    };
+  }
+  else if (algorithm == "pridge") {
+    const Params::Point_ridge_detection params{
+      static_cast<std::size_t>(dial.pridge_detection_nb_neighbors->value()),
+      dial.pridge_detection_sharpness_ratio->value()};
+    run = [params](Scene &scene, const std::string &fname) {
+      return scene.point_ridge_detection(fname, params);
+    };
+  }
+  else {
+    std::cerr << "unknown snapshot algorithm " << algorithm << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Snapshot_renderer renderer;
+  if (!QDir().mkpath(QString::fromStdString(output))
+    || !renderer.initialize(width, height))
+    return EXIT_FAILURE;
+
+  // one scene per file, the rendering stays on this thread with the context
+  int status = EXIT_SUCCESS;
+  for (std::size_t first = 0; first < files.size(); first += nb_jobs) {
+    const std::size_t nb_files = std::min(nb_jobs, files.size() - first);
+    std::vector<std::unique_ptr<Scene>> scenes(nb_files);
+    std::vector<int> results(nb_files, -1);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < nb_files; ++i)
+      workers.emplace_back([&, i]() {
+        // an exception would terminate the batch, the file is failed instead
+        try {
+          scenes[i].reset(new Scene());
+          results[i] = run(*scenes[i], files[first + i]);
+        }
+        catch (const std::exception &e) {
+          std::cerr << files[first + i] << ": " << e.what() << std::endl;
+          scenes[i].reset();
+          results[i] = -1;
+        }
+        catch (...) {
+          std::cerr << files[first + i] << ": unknown exception" << std::endl;
+          scenes[i].reset();
+          results[i] = -1;
+        }
+      });
+    for (std::thread &worker : workers)
+      worker.join();
+
+    for (std::size_t i = 0; i < nb_files; ++i) {
+      const std::string fname = output + "/" + QFileInfo(
+        QString::fromStdString(files[first + i])).completeBaseName().toStdString() + ".png";
+      if (results[i] < 0 || !renderer.render(*scenes[i], fname)) {
+        std::cerr << "no snapshot of " << files[first + i] << std::endl;
+        status = EXIT_FAILURE;
+      }
+      else
+        std::cout << "#snapshot " << fname << std::endl;
+      scenes[i].reset();
+    }
+  }
+
+  return status;
+}
+
 int main(int argc, char **argv)
 {
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--simplify"))
+      return batch_simplify(argc, argv);
+    if (!std::strcmp(argv[i], "--snapshot"))
+      return batch_snapshot(argc, argv);
+  }
+
   QApplication app(argc, argv);
   app.setOrganizationDomain("ia.cas.cn");
   app.setOrganizationName("CASIA");
@@ -3,6 +3,38 @@
 
 namespace Params {
 
+struct Surface_simplification {
+  /// Stop criterion of the edge collapses.
+  enum Stop { FACE_BUDGET, EDGE_RATIO, MAX_ERROR };
+  Stop stop;
+  /// Number of triangles to keep, for FACE_BUDGET.
+  std::size_t nb_faces;
+  /// Ratio of the initial edges to keep, for EDGE_RATIO.
+  double ratio;
+  /// Maximum distance of a new vertex to the faces it replaces, for MAX_ERROR.
+  double max_error;
+  /// Lindstrom-Turk cost and placement, edge length and midpoint otherwise.
+  bool lindstrom_turk;
+  /// Number of faces per region simplified in parallel, 0 for the serial simplification.
+  std::size_t region_faces;
+  /// Grid resolution of a vertex clustering before the edge collapses, 0 to skip.
+  unsigned int cluster_resolution;
+  /// Number of levels of detail below the input, each with a quarter of the faces
+  /// of the previous one, replaces the stop criterion, 0 for a single result.
+  unsigned int nb_lods;
+  /// Record the collapses into a progressive mesh.
+  bool progressive;
+  /// Peak memory in MB of an out-of-core simplification streamed from the file, 0 to load the whole mesh.
+  std::size_t memory_budget;
+  /// Number of surface samples of the Hausdorff and RMS error report, 0 to skip it.
+  std::size_t error_samples;
+};
+
+struct Vertex_clustering {
+  /// Number of grid cells along the longest axis of the bounding box.
+  unsigned int resolution;
+};
+
 struct Shape_detection {
   /// Sets probability to miss the largest primitive at each iteration.
   double probability;
@@ -16,6 +48,26 @@ struct Shape_detection {
   double normal_threshold;
 };
 
+struct Ridge_detection {
+  /// Number of rings used for the jet fitting, 0 to seek the minimum number of rings.
+  unsigned int nb_rings;
+  /// Exact number of points used for the jet fitting, 0 to use rings.
+  unsigned int nb_points_to_use;
+  /// Number of fitting scales, scale k adds k rings, or k times nb_points_to_use points, to the first.
+  unsigned int nb_scales;
+  /// Size of the patch to look for umbilics.
+  double umb_size;
+  /// Number of faces per spatial patch for large meshes, 0 to process the whole mesh at once.
+  unsigned int patch_size;
+};
+
+struct Point_ridge_detection {
+  /// Number of nearest neighbors used for the jet fitting.
+  std::size_t nb_neighbors;
+  /// Sharp points have a curvature above this ratio times the mean curvature.
+  double sharpness_ratio;
+};
+
 } // Params
 
 #endif // PARAMETERS_H
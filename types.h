@@ -2,7 +2,6 @@
 #define ALG_VIS_TYPES_H
 
 #include <CGAL/Simple_cartesian.h>
-#include <CGAL/Polyhedron_3.h>
 #include <CGAL/Surface_mesh.h>
 #include <CGAL/Bbox_3.h>
 
@@ -15,7 +14,6 @@ typedef Kernel::Vector_3 Vector_3;
 typedef Kernel::Segment_3 Segment_3;
 typedef Kernel::Triangle_3 Triangle_3;
 
-typedef CGAL::Polyhedron_3<Kernel> Polyhedron;
 typedef CGAL::Bbox_3 Bbox_3;
 
 typedef CGAL::Surface_mesh<Point_3> Surface_mesh;